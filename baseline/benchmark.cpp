@@ -1,17 +1,89 @@
 #include "kvstore.hpp"
+#include "swiss_kvstore.hpp"
+#include "cuckoo_kvstore.hpp"
+#include "two_choice_kvstore.hpp"
+#include "tiered_kvstore.hpp"
+#include "frozen_kvstore.hpp"
+#include "concurrent_kvstore.hpp"
+#include "epoch_kvstore.hpp"
+#include "sharded_kvstore.hpp"
+#include "linear_scan_kvstore.hpp"
+#include "var_kvstore.hpp"
 #include "benchmark_utils.hpp"
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <cstdlib>
 #include <vector>
 #include <algorithm>
 #include <thread>
+#include <atomic>
 #include <chrono>
+#include <type_traits>
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+#include "kvstore_coro.hpp"
+#define KV_BENCHMARK_HAS_COROUTINES 1
+#endif
 
 // Constants for default benchmark parameters
 const size_t DEFAULT_DATA_SIZE = 1000000; // 1M
 const size_t DEFAULT_OPERATIONS = 2000000; // 2M
 const double DEFAULT_READ_RATIO = 0.5;
 
+// Maximum load factor used to size the stores; 0 keeps the legacy sizing of
+// twice the data size
+double tableLoadFactor = 0.0;
+
+// Page backing and prefaulting of table and value memory, for stores that
+// take a TableMemoryPolicy
+TableMemoryPolicy tableMemory;
+
+// Load the initial data with bulkLoad (stores that have it) instead of one
+// insert per key
+bool bulkLoadInitialData = false;
+
+// Prefix of the snapshot files the initial data is opened from (and saved
+// to when missing); empty to always insert
+std::string snapshotPrefix;
+
+// Value-size distributions of --mode=varsize; empty for the default set
+std::vector<ValueSizeDistribution> valueSizeDistributions;
+
+// Store instantiations selectable from the command line
+template<typename K, size_t ValueSize>
+using DefaultKVStore = KVStore<K, ValueSize>;
+
+template<typename K, size_t ValueSize>
+using IndirectKVStore = KVStore<K, ValueSize, IndirectKVStoreTraits<K, ValueSize>>;
+
+template<typename K, size_t ValueSize>
+using CompactKVStore = KVStore<K, ValueSize, CompactKVStoreTraits<K, ValueSize>>;
+
+template<typename K, size_t ValueSize>
+using ObliviousKVStore = KVStore<K, ValueSize, ObliviousKVStoreTraits<K, ValueSize>>;
+
+template<typename K, size_t ValueSize>
+using DefaultSwissKVStore = SwissKVStore<K, ValueSize>;
+
+template<typename K, size_t ValueSize>
+using IndirectSwissKVStore = SwissKVStore<K, ValueSize, IndirectKVStoreTraits<K, ValueSize>>;
+
+template<typename K, size_t ValueSize>
+using DefaultCuckooKVStore = CuckooKVStore<K, ValueSize>;
+
+template<typename K, size_t ValueSize>
+using IndirectCuckooKVStore = CuckooKVStore<K, ValueSize, IndirectKVStoreTraits<K, ValueSize>>;
+
+template<typename K, size_t ValueSize>
+using DefaultConcurrentKVStore = ConcurrentKVStore<K, ValueSize>;
+
+template<typename K, size_t ValueSize>
+using IndirectConcurrentKVStore = ConcurrentKVStore<K, ValueSize, IndirectKVStoreTraits<K, ValueSize>>;
+
+template<typename K, size_t ValueSize>
+using DefaultEpochKVStore = EpochKVStore<K, ValueSize>;
+
 // Warm-up function to ensure consistent system state
 void warmupSystem() {
     // Simple computation to warm up the CPU
@@ -24,8 +96,112 @@ void warmupSystem() {
     std::this_thread::sleep_for(std::chrono::milliseconds(50));
 }
 
+// Print overflow stash counters for stores that have a stash
+template<typename Store>
+auto printStashStats(const Store& store, int) -> decltype(store.stashStats(), void()) {
+    auto stats = store.stashStats();
+    std::cout << "Stash occupancy: " << stats.size << " / " << stats.capacity
+            << " (peak " << stats.peak << ", total overflows " << stats.overflows << ")" << std::endl;
+}
+
+template<typename Store>
+void printStashStats(const Store&, long) {}
+
+// Create a store with double the data size, or sized to the requested load
+// factor when one was given. Stores that accept a memory policy get
+// tableMemory.
+template<typename Store>
+Store makeStore(size_t dataSize) {
+    if constexpr (std::is_constructible_v<Store, size_t, double, TableMemoryPolicy>) {
+        return tableLoadFactor > 0.0 ? Store(dataSize, tableLoadFactor, tableMemory)
+                                     : Store(dataSize * 2, tableMemory);
+    } else {
+        return tableLoadFactor > 0.0 ? Store(dataSize, tableLoadFactor) : Store(dataSize * 2);
+    }
+}
+
+// Page backing a store's table got, for stores that report it
+template<typename Store>
+auto printPageBacking(const Store& store, int) -> decltype(store.tablePageBacking(), void()) {
+    std::cout << "Table pages: " << hugePagesName(store.tablePageBacking()) << std::endl;
+}
+
+template<typename Store>
+void printPageBacking(const Store&, long) {}
+
+// Read the value of key into dst through getInto when the store has it (one
+// copy, no zero-filled temporary), through get otherwise
+template<typename Store, typename K, size_t N>
+auto readValue(Store& store, K key, std::array<uint8_t, N>& dst, int)
+    -> decltype(store.getInto(key, dst.data())) {
+    return store.getInto(key, dst.data());
+}
+
+template<typename Store, typename K, size_t N>
+bool readValue(Store& store, K key, std::array<uint8_t, N>& dst, long) {
+    dst = store.get(key);
+    return true;
+}
+
+// Stores that can be saved to and opened from a snapshot file
+template<typename Store, typename = void>
+struct SupportsSnapshots : std::false_type {};
+
+template<typename Store>
+struct SupportsSnapshots<Store, std::enable_if_t<Store::SUPPORTS_SNAPSHOTS>> : std::true_type {};
+
+// Snapshot file for one store configuration and data size
+template<typename Store>
+std::string snapshotFile(size_t dataSize) {
+    return snapshotPrefix + "." + std::to_string(sizeof(typename Store::KeyType)) + "k" +
+           std::to_string(sizeof(typename Store::ValueType)) + "v" + std::to_string(dataSize) + ".kvsnap";
+}
+
+// Initial data through bulkLoad when the store has it, one insert per key
+// otherwise
+template<typename Store, typename K, typename V>
+auto loadInitialData(Store& store, const K* keys, const V* values, size_t n, int)
+    -> decltype(store.bulkLoad(keys, values, n), void()) {
+    store.bulkLoad(keys, values, n);
+}
+
+template<typename Store, typename K, typename V>
+void loadInitialData(Store& store, const K* keys, const V* values, size_t n, long) {
+    for (size_t i = 0; i < n; i++) {
+        store.insert(keys[i], values[i]);
+    }
+}
+
+// Batched get/update through multiGet/multiUpdate when the store has them,
+// one key at a time otherwise
+template<typename Store, typename K, typename V>
+auto batchGet(Store& store, const K* keys, size_t n, V* out, int)
+    -> decltype(store.multiGet(keys, n, out), void()) {
+    store.multiGet(keys, n, out);
+}
+
+template<typename Store, typename K, typename V>
+void batchGet(Store& store, const K* keys, size_t n, V* out, long) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = store.get(keys[i]);
+    }
+}
+
+template<typename Store, typename K, typename V>
+auto batchUpdate(Store& store, const K* keys, size_t n, const V* values, int)
+    -> decltype(store.multiUpdate(keys, n, values), void()) {
+    store.multiUpdate(keys, n, values);
+}
+
+template<typename Store, typename K, typename V>
+void batchUpdate(Store& store, const K* keys, size_t n, const V* values, long) {
+    for (size_t i = 0; i < n; i++) {
+        store.update(keys[i], values[i]);
+    }
+}
+
 // Unified benchmark function that handles all test cases
-template<typename K, size_t ValueSize>
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
 void runBenchmark(
     size_t dataSize,
     double readRatio,
@@ -37,8 +213,9 @@ void runBenchmark(
     // Warm up system before benchmark
     warmupSystem();
     
-    // Create KV store with double the data size for better performance
-    KVStore<K, ValueSize> kvStore(dataSize * 2);
+    // Create KV store with double the data size for better performance,
+    // or sized to the requested load factor
+    auto kvStore = makeStore<Store<K, ValueSize>>(dataSize);
     
     // Initialize random number generator with fixed seed for reproducibility
     std::mt19937 gen(42);
@@ -48,15 +225,66 @@ void runBenchmark(
         std::cout << "Performing initial data insertion..." << std::endl;
     }
     
+    using StoreType = Store<K, ValueSize>;
     Timer insertTimer;
-    insertTimer.start();
-    
-    for (size_t i = 0; i < dataSize; i++) {
-        auto value = generateRandomData<ValueSize>(gen);
-        kvStore.insert(static_cast<K>(i), value);
+    double insertTime;
+    bool fromSnapshot = false;
+    if constexpr (SupportsSnapshots<StoreType>::value) {
+        if (!snapshotPrefix.empty()) {
+            try {
+                insertTimer.start();
+                kvStore = StoreType::openSnapshot(snapshotFile<StoreType>(dataSize));
+                insertTime = insertTimer.elapsedMilliseconds();
+                fromSnapshot = true;
+                // Same random stream as after inserting, for the mixed phase
+                for (size_t i = 0; i < dataSize; i++) {
+                    generateRandomData<ValueSize>(gen);
+                }
+            } catch (const std::exception&) {
+                // Missing or stale: built below and saved afterwards
+            }
+        }
+    }
+    if (fromSnapshot) {
+        // Opened above
+    } else if (bulkLoadInitialData) {
+        // Keys and values are generated before the timer starts
+        std::vector<K> keys(dataSize);
+        std::vector<std::array<uint8_t, ValueSize>> values(dataSize);
+        for (size_t i = 0; i < dataSize; i++) {
+            keys[i] = static_cast<K>(i);
+            values[i] = generateRandomData<ValueSize>(gen);
+        }
+        insertTimer.start();
+        loadInitialData(kvStore, keys.data(), values.data(), dataSize, 0);
+        insertTime = insertTimer.elapsedMilliseconds();
+    } else {
+        insertTimer.start();
+        for (size_t i = 0; i < dataSize; i++) {
+            auto value = generateRandomData<ValueSize>(gen);
+            kvStore.insert(static_cast<K>(i), value);
+        }
+        insertTime = insertTimer.elapsedMilliseconds();
     }
     
-    double insertTime = insertTimer.elapsedMilliseconds();
+    if constexpr (SupportsSnapshots<StoreType>::value) {
+        if (!snapshotPrefix.empty() && printDetails) {
+            std::cout << std::fixed << std::setprecision(3);
+            if (fromSnapshot) {
+                std::cout << "Opened snapshot " << snapshotFile<StoreType>(dataSize) << " in "
+                        << insertTime << " milliseconds" << std::endl;
+            }
+        }
+        if (!snapshotPrefix.empty() && !fromSnapshot) {
+            Timer saveTimer;
+            saveTimer.start();
+            kvStore.saveSnapshot(snapshotFile<StoreType>(dataSize));
+            if (printDetails) {
+                std::cout << "Saved snapshot " << snapshotFile<StoreType>(dataSize) << " in "
+                        << saveTimer.elapsedMilliseconds() << " milliseconds" << std::endl;
+            }
+        }
+    }
     
     // Generate random operations
     auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
@@ -66,13 +294,20 @@ void runBenchmark(
         std::cout << "Testing mixed operations..." << std::endl;
     }
     
+    // dTLB misses over the mixed phase (unavailable without perf access)
+    PerfCounter dtlbMisses = PerfCounter::dtlbLoadMisses();
+    
     Timer mixedTimer;
     mixedTimer.start();
+    dtlbMisses.start();
     
     size_t gets = 0, updates = 0;
+    std::array<uint8_t, ValueSize> readBuffer{};
+    volatile uint8_t sink = 0;
     for (const auto& op : operations) {
         if (op.first == 0) {
-            auto result = kvStore.get(static_cast<K>(op.second));
+            readValue(kvStore, static_cast<K>(op.second), readBuffer, 0);
+            sink = sink + readBuffer[0];
             gets++;
         } else {
             auto newValue = generateRandomData<ValueSize>(gen);
@@ -81,13 +316,14 @@ void runBenchmark(
         }
     }
     
+    uint64_t dtlbMissCount = dtlbMisses.stop();
     double mixedTime = mixedTimer.elapsedMilliseconds();
     
     // Print table header if requested
     if (printHeader) {
         if (printRow) {
-            std::cout << "| Data Size | Value Size | Insertion Time (ms) | Avg Insert (μs) | Mixed Ops Time (ms) | Avg Op Time (μs) |" << std::endl;
-            std::cout << "|-----------|------------|---------------------|-----------------|---------------------|------------------|" << std::endl;
+            std::cout << "| Data Size | Value Size | Insertion Time (ms) | Avg Insert (μs) | Mixed Ops Time (ms) | Avg Op Time (μs) | dTLB Miss/Op |" << std::endl;
+            std::cout << "|-----------|------------|---------------------|-----------------|---------------------|------------------|--------------|" << std::endl;
         } else {
             std::cout << std::fixed << std::setprecision(3);
             std::cout << "Initial insertion time for " << dataSize << " entries: " 
@@ -113,7 +349,12 @@ void runBenchmark(
                 << std::setw(19) << insertTime << " | "
                 << std::setw(16) << (insertTime * 1000.0 / dataSize) << " | "
                 << std::setw(19) << mixedTime << " | "
-                << std::setw(16) << (mixedTime * 1000.0 / numOperations) << " |" << std::endl;
+                << std::setw(16) << (mixedTime * 1000.0 / numOperations) << " | ";
+        if (dtlbMisses.available()) {
+            std::cout << std::setw(12) << static_cast<double>(dtlbMissCount) / numOperations << " |" << std::endl;
+        } else {
+            std::cout << std::setw(12) << "n/a" << " |" << std::endl;
+        }
     }
     
     // Print detailed results if requested
@@ -132,6 +373,13 @@ void runBenchmark(
                 << mixedTime << " milliseconds" << std::endl;
         std::cout << "Average time per operation: " 
                 << mixedTime * 1000.0 / numOperations << " microseconds" << std::endl;
+        if (dtlbMisses.available()) {
+            std::cout << "dTLB load misses per operation: "
+                    << static_cast<double>(dtlbMissCount) / numOperations << std::endl;
+        }
+        std::cout << "Store memory: " << kvStore.memoryUsage() / (1024.0 * 1024.0) << " MiB" << std::endl;
+        printPageBacking(kvStore, 0);
+        printStashStats(kvStore, 0);
         
         // Print sample values
         std::cout << "\nSample values:" << std::endl;
@@ -145,7 +393,7 @@ void runBenchmark(
 }
 
 // Benchmark (i): Fixed 1M data, fixed value size
-template<typename K, size_t ValueSize>
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
 void runFixedSizeBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
     const size_t dataSize = DEFAULT_DATA_SIZE;
     
@@ -155,23 +403,105 @@ void runFixedSizeBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOper
     std::cout << "----------------------------------------------------------" << std::endl;
     
     // Run the benchmark with detailed output
-    runBenchmark<K, ValueSize>(dataSize, readRatio, numOperations, true, false, false);
+    runBenchmark<K, ValueSize, Store>(dataSize, readRatio, numOperations, true, false, false);
 }
 
-// Benchmark (ii): Variable data size with fixed value size
+// Slot reads (slots scanned times queries) allowed per data size for the
+// linear-scan rows; larger tables run fewer operations
+const double LINEAR_SCAN_BUDGET = 2e9;
+
+// Linear-scan oblivious map over the data sizes of benchmark (ii). The
+// initial data is appended without scanning; the mixed workload is issued
+// in batches of up to 32 commands whose gets share one pass over the table
+// (multiGet) and whose updates share one read and one write pass
+// (multiUpdate). Every access reads the whole table, so the operation count
+// shrinks with the data size to keep each row within LINEAR_SCAN_BUDGET.
 template<typename K, size_t ValueSize>
+void runLinearScanDataSizeRows(const std::vector<size_t>& dataSizes, double readRatio, size_t numOperations) {
+    using StoreType = LinearScanKVStore<K, ValueSize>;
+    using ValueType = std::array<uint8_t, ValueSize>;
+    const size_t batchSize = 32;
+    
+    {
+        StoreType probe(1);
+        std::cout << "\nLinear-scan oblivious map (" << scanIsaName(probe.scanIsa()) << ", "
+                << probe.scanThreads() << " scan thread(s), batches of " << batchSize << ")" << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Data Size | Value Size | Load Time (ms) | Operations | Mixed Ops Time (ms) | Avg Op Time (μs) | Scan Passes |" << std::endl;
+    std::cout << "|-----------|------------|----------------|------------|---------------------|------------------|-------------|" << std::endl;
+    
+    for (size_t dataSize : dataSizes) {
+        size_t ops = std::min(numOperations, std::max(batchSize, static_cast<size_t>(LINEAR_SCAN_BUDGET / dataSize)));
+        warmupSystem();
+        auto kvStore = makeStore<StoreType>(dataSize);
+        
+        std::mt19937 gen(42);
+        std::vector<K> keys(dataSize);
+        std::vector<ValueType> values(dataSize);
+        for (size_t i = 0; i < dataSize; i++) {
+            keys[i] = static_cast<K>(i);
+            values[i] = generateRandomData<ValueSize>(gen);
+        }
+        Timer loadTimer;
+        loadTimer.start();
+        kvStore.append(keys.data(), values.data(), dataSize);
+        double loadTime = loadTimer.elapsedMilliseconds();
+        
+        auto operations = generateRandomOperations(ops, dataSize, readRatio);
+        std::vector<ValueType> newValues(ops);
+        for (auto& value : newValues) {
+            value = generateRandomData<ValueSize>(gen);
+        }
+        
+        std::vector<K> getKeys(batchSize), updateKeys(batchSize);
+        std::vector<ValueType> getResults(batchSize), updateValues(batchSize);
+        size_t passesBefore = kvStore.scanPasses();
+        Timer mixedTimer;
+        mixedTimer.start();
+        for (size_t base = 0; base < ops; base += batchSize) {
+            size_t end = std::min(base + batchSize, ops);
+            size_t gets = 0, updates = 0;
+            for (size_t i = base; i < end; i++) {
+                K key = static_cast<K>(operations[i].second);
+                if (operations[i].first == 0) {
+                    getKeys[gets++] = key;
+                } else {
+                    updateKeys[updates] = key;
+                    updateValues[updates++] = newValues[i];
+                }
+            }
+            kvStore.multiGet(getKeys.data(), gets, getResults.data());
+            kvStore.multiUpdate(updateKeys.data(), updates, updateValues.data());
+        }
+        double mixedTime = mixedTimer.elapsedMilliseconds();
+        
+        std::cout << "| " << std::setw(9) << dataSize << " | "
+                << std::setw(10) << ValueSize << " bytes | "
+                << std::setw(14) << loadTime << " | "
+                << std::setw(10) << ops << " | "
+                << std::setw(19) << mixedTime << " | "
+                << std::setw(16) << (mixedTime * 1000.0 / ops) << " | "
+                << std::setw(11) << kvStore.scanPasses() - passesBefore << " |" << std::endl;
+    }
+}
+
+// Benchmark (ii): Variable data size with fixed value size
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
 void runVaryingDataSizeBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
     std::vector<size_t> dataSizes = {100000, 500000, 1000000, 5000000, 10000000}; // 100K, 500K, 1M, 5M, 10M
     
     std::cout << "\n==========================================================" << std::endl;
     std::cout << "Benchmark (ii): Varying data size with " << ValueSize << "-byte value" << std::endl;
     std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "Huge pages: " << hugePagesName(tableMemory.hugePages)
+              << (tableMemory.prefault ? ", prefaulted" : "") << std::endl;
     std::cout << "----------------------------------------------------------" << std::endl;
     
     // Print the table header
     std::cout << std::fixed << std::setprecision(3);
-    std::cout << "| Data Size | Value Size | Insertion Time (ms) | Avg Insert (μs) | Mixed Ops Time (ms) | Avg Op Time (μs) |" << std::endl;
-    std::cout << "|-----------|------------|---------------------|-----------------|---------------------|------------------|" << std::endl;
+    std::cout << "| Data Size | Value Size | Insertion Time (ms) | Avg Insert (μs) | Mixed Ops Time (ms) | Avg Op Time (μs) | dTLB Miss/Op |" << std::endl;
+    std::cout << "|-----------|------------|---------------------|-----------------|---------------------|------------------|--------------|" << std::endl;
     
     // Run benchmarks for each data size
     for (const auto& dataSize : dataSizes) {
@@ -179,12 +509,15 @@ void runVaryingDataSizeBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t n
         size_t adjustedOps = numOperations;
         
         // Run the benchmark with row output
-        runBenchmark<K, ValueSize>(dataSize, readRatio, adjustedOps, false, false, true);
+        runBenchmark<K, ValueSize, Store>(dataSize, readRatio, adjustedOps, false, false, true);
     }
+    
+    // Full-scan oblivious comparator over the same sizes
+    runLinearScanDataSizeRows<K, ValueSize>(dataSizes, readRatio, numOperations);
 }
 
 // Benchmark (iii): Fixed data size with varying value sizes
-template<typename K>
+template<typename K, template<typename, size_t> class Store = DefaultKVStore>
 void runVaryingValueSizeBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
     const size_t dataSize = DEFAULT_DATA_SIZE; // 1M
     
@@ -195,47 +528,1577 @@ void runVaryingValueSizeBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t
     
     // Print the table header
     std::cout << std::fixed << std::setprecision(3);
-    std::cout << "| Data Size | Value Size | Insertion Time (ms) | Avg Insert (μs) | Mixed Ops Time (ms) | Avg Op Time (μs) |" << std::endl;
-    std::cout << "|-----------|------------|---------------------|-----------------|---------------------|------------------|" << std::endl;
+    std::cout << "| Data Size | Value Size | Insertion Time (ms) | Avg Insert (μs) | Mixed Ops Time (ms) | Avg Op Time (μs) | dTLB Miss/Op |" << std::endl;
+    std::cout << "|-----------|------------|---------------------|-----------------|---------------------|------------------|--------------|" << std::endl;
     
     // Run benchmarks for different value sizes
-    runBenchmark<K, 8>(dataSize, readRatio, numOperations, false, false, true);
-    runBenchmark<K, 16>(dataSize, readRatio, numOperations, false, false, true);
-    runBenchmark<K, 32>(dataSize, readRatio, numOperations, false, false, true);
-    runBenchmark<K, 64>(dataSize, readRatio, numOperations, false, false, true);
-    runBenchmark<K, 128>(dataSize, readRatio, numOperations, false, false, true);
-    runBenchmark<K, 256>(dataSize, readRatio, numOperations, false, false, true);
+    runBenchmark<K, 8, Store>(dataSize, readRatio, numOperations, false, false, true);
+    runBenchmark<K, 16, Store>(dataSize, readRatio, numOperations, false, false, true);
+    runBenchmark<K, 32, Store>(dataSize, readRatio, numOperations, false, false, true);
+    runBenchmark<K, 64, Store>(dataSize, readRatio, numOperations, false, false, true);
+    runBenchmark<K, 128, Store>(dataSize, readRatio, numOperations, false, false, true);
+    runBenchmark<K, 256, Store>(dataSize, readRatio, numOperations, false, false, true);
+}
+
+// Growth benchmark: insert dataSize keys into a store that starts sized for
+// a few thousand keys, recording the latency of every insert while it grows,
+// next to the same run on a presized store
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
+void runGrowthBenchmark(size_t dataSize = DEFAULT_DATA_SIZE) {
+    const size_t undersized = 4096;
+    const double loadFactor = tableLoadFactor > 0.0 ? tableLoadFactor : 0.75;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Growth benchmark: " << dataSize << " inserts, " << ValueSize << "-byte value, max load factor " << loadFactor << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Initial Keys | Total Time (ms) | Avg (μs) | p50 (μs) | p99 (μs) | p99.9 (μs) | Max (μs) | Memory (MiB) |" << std::endl;
+    std::cout << "|--------------|-----------------|----------|----------|----------|------------|----------|--------------|" << std::endl;
+    
+    // Generate the values up front so only the insert is timed
+    std::mt19937 gen(42);
+    std::vector<std::array<uint8_t, ValueSize>> values(dataSize);
+    for (auto& value : values) {
+        value = generateRandomData<ValueSize>(gen);
+    }
+    
+    for (size_t initialKeys : {undersized, dataSize}) {
+        warmupSystem();
+        Store<K, ValueSize> kvStore(initialKeys, loadFactor);
+        
+        LatencyRecorder latencies;
+        latencies.reserve(dataSize);
+        uint64_t start = nowNanoseconds();
+        for (size_t i = 0; i < dataSize; i++) {
+            uint64_t t0 = nowNanoseconds();
+            kvStore.insert(static_cast<K>(i), values[i]);
+            latencies.record(nowNanoseconds() - t0);
+        }
+        double totalMs = (nowNanoseconds() - start) / 1e6;
+        
+        std::cout << "| " << std::setw(12) << initialKeys << " | "
+                << std::setw(15) << totalMs << " | "
+                << std::setw(8) << latencies.mean() / 1000.0 << " | "
+                << std::setw(8) << latencies.percentile(50) / 1000.0 << " | "
+                << std::setw(8) << latencies.percentile(99) / 1000.0 << " | "
+                << std::setw(10) << latencies.percentile(99.9) / 1000.0 << " | "
+                << std::setw(8) << latencies.max() / 1000.0 << " | "
+                << std::setw(12) << kvStore.memoryUsage() / (1024.0 * 1024.0) << " |" << std::endl;
+    }
+}
+
+// Batch-size sweep: the mixed workload is issued in batches of B commands,
+// like BOLT's CMD_SIZE command buffers. Within a batch the gets are resolved
+// with multiGet first, then the updates with multiUpdate. The unbatched row
+// runs the same commands through get/update one at a time.
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
+void runBatchSweepBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t dataSize = DEFAULT_DATA_SIZE,
+                            size_t numOperations = DEFAULT_OPERATIONS) {
+    using ValueType = std::array<uint8_t, ValueSize>;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Batch-size sweep: " << dataSize << " keys, " << ValueSize << "-byte value" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    warmupSystem();
+    auto kvStore = makeStore<Store<K, ValueSize>>(dataSize);
+    std::mt19937 gen(42);
+    for (size_t i = 0; i < dataSize; i++) {
+        kvStore.insert(static_cast<K>(i), generateRandomData<ValueSize>(gen));
+    }
+    
+    auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+    std::vector<ValueType> newValues(numOperations);
+    for (auto& value : newValues) {
+        value = generateRandomData<ValueSize>(gen);
+    }
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Batch Size | Mixed Ops Time (ms) | Avg Op Time (μs) | Throughput (Mops/s) |" << std::endl;
+    std::cout << "|------------|---------------------|------------------|---------------------|" << std::endl;
+    auto printRow = [&](const std::string& label, double ms) {
+        std::cout << "| " << std::setw(10) << label << " | "
+                << std::setw(19) << ms << " | "
+                << std::setw(16) << ms * 1000.0 / numOperations << " | "
+                << std::setw(19) << numOperations / (ms * 1000.0) << " |" << std::endl;
+    };
+    
+    Timer timer;
+    timer.start();
+    for (size_t i = 0; i < numOperations; i++) {
+        K key = static_cast<K>(operations[i].second);
+        if (operations[i].first == 0) {
+            auto result = kvStore.get(key);
+            (void)result;
+        } else {
+            kvStore.update(key, newValues[i]);
+        }
+    }
+    printRow("unbatched", timer.elapsedMilliseconds());
+    
+    std::vector<K> getKeys, updateKeys;
+    std::vector<ValueType> getResults, updateValues;
+    for (size_t batchSize : {1, 2, 4, 8, 16, 32, 64, 128, 256}) {
+        getKeys.resize(batchSize);
+        getResults.resize(batchSize);
+        updateKeys.resize(batchSize);
+        updateValues.resize(batchSize);
+        
+        timer.start();
+        for (size_t base = 0; base < numOperations; base += batchSize) {
+            size_t end = std::min(base + batchSize, numOperations);
+            size_t gets = 0, updates = 0;
+            for (size_t i = base; i < end; i++) {
+                K key = static_cast<K>(operations[i].second);
+                if (operations[i].first == 0) {
+                    getKeys[gets++] = key;
+                } else {
+                    updateKeys[updates] = key;
+                    updateValues[updates++] = newValues[i];
+                }
+            }
+            batchGet(kvStore, getKeys.data(), gets, getResults.data(), 0);
+            batchUpdate(kvStore, updateKeys.data(), updates, updateValues.data(), 0);
+        }
+        printRow(std::to_string(batchSize), timer.elapsedMilliseconds());
+    }
+}
+
+// Stores exposing the split-phase API needed for interleaved execution
+template<typename Store, typename = void>
+struct SupportsInterleaving : std::false_type {};
+
+template<typename Store>
+struct SupportsInterleaving<Store, std::void_t<decltype(std::declval<Store&>().prefetchKey(typename Store::KeyType{}))>>
+    : std::true_type {};
+
+// Coroutine-interleaved execution: the mixed workload runs through an
+// InterleavedExecutor at several interleaving degrees, next to the plain
+// one-operation-at-a-time loop of runBenchmark
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
+void runInterleavedBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t dataSize = DEFAULT_DATA_SIZE,
+                             [[maybe_unused]] size_t numOperations = DEFAULT_OPERATIONS) {
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Interleaved (coroutine) execution: " << dataSize << " keys, " << ValueSize << "-byte value" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+#ifdef KV_BENCHMARK_HAS_COROUTINES
+    using StoreType = Store<K, ValueSize>;
+    using ValueType = std::array<uint8_t, ValueSize>;
+    
+    if constexpr (!SupportsInterleaving<StoreType>::value) {
+        std::cout << "This engine has no split-phase API; skipping." << std::endl;
+    } else {
+        warmupSystem();
+        auto kvStore = makeStore<StoreType>(dataSize);
+        std::mt19937 gen(42);
+        for (size_t i = 0; i < dataSize; i++) {
+            kvStore.insert(static_cast<K>(i), generateRandomData<ValueSize>(gen));
+        }
+        
+        auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+        std::vector<ValueType> newValues(numOperations);
+        for (auto& value : newValues) {
+            value = generateRandomData<ValueSize>(gen);
+        }
+        std::vector<ValueType> results(numOperations);
+        
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "| In Flight | Mixed Ops Time (ms) | Avg Op Time (μs) | Throughput (Mops/s) |" << std::endl;
+        std::cout << "|-----------|---------------------|------------------|---------------------|" << std::endl;
+        auto printRow = [&](const std::string& label, double ms) {
+            std::cout << "| " << std::setw(9) << label << " | "
+                    << std::setw(19) << ms << " | "
+                    << std::setw(16) << ms * 1000.0 / numOperations << " | "
+                    << std::setw(19) << numOperations / (ms * 1000.0) << " |" << std::endl;
+        };
+        
+        Timer timer;
+        timer.start();
+        for (size_t i = 0; i < numOperations; i++) {
+            K key = static_cast<K>(operations[i].second);
+            if (operations[i].first == 0) {
+                results[i] = kvStore.get(key);
+            } else {
+                kvStore.update(key, newValues[i]);
+            }
+        }
+        printRow("plain", timer.elapsedMilliseconds());
+        
+        for (size_t degree : {1, 2, 4, 8, 16, 32}) {
+            timer.start();
+            InterleavedExecutor<StoreType> executor(kvStore, degree);
+            for (size_t i = 0; i < numOperations; i++) {
+                K key = static_cast<K>(operations[i].second);
+                if (operations[i].first == 0) {
+                    executor.get(key, &results[i]);
+                } else {
+                    executor.update(key, newValues[i]);
+                }
+            }
+            executor.drain();
+            printRow(std::to_string(degree), timer.elapsedMilliseconds());
+        }
+    }
+#else
+    std::cout << "Coroutine mode needs a C++20 build (-std=c++20); skipping." << std::endl;
+#endif
+}
+
+// Thread scaling: every thread runs its own stream of the mixed workload
+// against one shared store; reports aggregate throughput and the latency of
+// every GET_SAMPLE_INTERVAL-th get per thread count. Only meaningful for
+// thread-safe engines.
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultConcurrentKVStore>
+void runThreadScalingBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t dataSize = DEFAULT_DATA_SIZE,
+                               size_t opsPerThread = DEFAULT_OPERATIONS) {
+    using ValueType = std::array<uint8_t, ValueSize>;
+    constexpr size_t VALUE_POOL = 1024; // Distinct update values per thread
+    constexpr size_t GET_SAMPLE_INTERVAL = 16;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Thread scaling: " << dataSize << " keys, " << ValueSize << "-byte value, "
+            << opsPerThread << " ops per thread" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    warmupSystem();
+    auto kvStore = makeStore<Store<K, ValueSize>>(dataSize);
+    std::mt19937 gen(42);
+    for (size_t i = 0; i < dataSize; i++) {
+        kvStore.insert(static_cast<K>(i), generateRandomData<ValueSize>(gen));
+    }
+    
+    std::vector<size_t> threadCounts = {1, 2, 4, 8, 16};
+    size_t hardwareThreads = std::thread::hardware_concurrency();
+    if (hardwareThreads > threadCounts.back()) {
+        threadCounts.push_back(hardwareThreads);
+    }
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Threads | Mixed Ops Time (ms) | Throughput (Mops/s) | Per Thread (Mops/s) | Get p50 (ns) | Get p99 (ns) | Get p99.9 (ns) |" << std::endl;
+    std::cout << "|---------|---------------------|---------------------|---------------------|--------------|--------------|----------------|" << std::endl;
+    
+    for (size_t threads : threadCounts) {
+        // Per-thread operations and update values, generated up front
+        std::vector<std::vector<std::pair<int, int>>> operations(threads);
+        std::vector<std::vector<ValueType>> newValues(threads);
+        std::vector<LatencyRecorder> getLatency(threads);
+        for (size_t t = 0; t < threads; t++) {
+            operations[t] = generateRandomOperations(opsPerThread, dataSize, readRatio);
+            newValues[t].resize(VALUE_POOL);
+            for (auto& value : newValues[t]) {
+                value = generateRandomData<ValueSize>(gen);
+            }
+            getLatency[t].reserve(opsPerThread / GET_SAMPLE_INTERVAL + 1);
+        }
+        
+        std::atomic<size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                ready++;
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                volatile uint8_t sink = 0;
+                size_t gets = 0;
+                for (size_t i = 0; i < opsPerThread; i++) {
+                    K key = static_cast<K>(operations[t][i].second);
+                    if (operations[t][i].first != 0) {
+                        kvStore.update(key, newValues[t][i % VALUE_POOL]);
+                    } else if (++gets % GET_SAMPLE_INTERVAL == 0) {
+                        uint64_t begin = nowNanoseconds();
+                        sink = sink + kvStore.get(key)[0];
+                        getLatency[t].record(nowNanoseconds() - begin);
+                    } else {
+                        sink = sink + kvStore.get(key)[0];
+                    }
+                }
+            });
+        }
+        while (ready.load() < threads) {
+            std::this_thread::yield();
+        }
+        
+        Timer timer;
+        timer.start();
+        go.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double ms = timer.elapsedMilliseconds();
+        double mops = threads * opsPerThread / (ms * 1000.0);
+        
+        LatencyRecorder allGets;
+        for (const auto& recorder : getLatency) {
+            allGets.merge(recorder);
+        }
+        
+        std::cout << "| " << std::setw(7) << threads << " | "
+                << std::setw(19) << ms << " | "
+                << std::setw(19) << mops << " | "
+                << std::setw(19) << mops / threads << " | "
+                << std::setw(12) << allGets.percentile(50) << " | "
+                << std::setw(12) << allGets.percentile(99) << " | "
+                << std::setw(14) << allGets.percentile(99.9) << " |" << std::endl;
+    }
+}
+
+// Timings of one probe policy
+struct ProbeTimes {
+    double mixedMs; // Mixed get/update workload
+    double hitNs;   // Average get of a present key
+    double missNs;  // Average get of an absent key
+};
+
+template<typename K, size_t ValueSize, template<typename, size_t> class Store>
+ProbeTimes timeProbePolicy(size_t dataSize, double readRatio, size_t numOperations) {
+    constexpr size_t PROBES = 1000000;
+    using ValueType = std::array<uint8_t, ValueSize>;
+    
+    warmupSystem();
+    auto kvStore = makeStore<Store<K, ValueSize>>(dataSize);
+    std::mt19937 gen(42);
+    for (size_t i = 0; i < dataSize; i++) {
+        kvStore.insert(static_cast<K>(i), generateRandomData<ValueSize>(gen));
+    }
+    
+    std::vector<ValueType> newValues(1024);
+    for (auto& value : newValues) {
+        value = generateRandomData<ValueSize>(gen);
+    }
+    auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+    volatile uint8_t sink = 0;
+    
+    Timer timer;
+    timer.start();
+    for (size_t i = 0; i < operations.size(); i++) {
+        K key = static_cast<K>(operations[i].second);
+        if (operations[i].first == 0) {
+            sink = sink + kvStore.get(key)[0];
+        } else {
+            kvStore.update(key, newValues[i % newValues.size()]);
+        }
+    }
+    ProbeTimes times{timer.elapsedMilliseconds(), 0.0, 0.0};
+    
+    // Same key distribution for hits and misses: misses are shifted past the
+    // loaded range
+    std::uniform_int_distribution<size_t> keyDis(0, dataSize - 1);
+    std::vector<K> probes(PROBES);
+    for (auto& key : probes) {
+        key = static_cast<K>(keyDis(gen));
+    }
+    for (bool hit : {true, false}) {
+        K offset = static_cast<K>(hit ? 0 : dataSize);
+        timer.start();
+        for (K key : probes) {
+            sink = sink + kvStore.get(key + offset)[0];
+        }
+        (hit ? times.hitNs : times.missNs) = timer.elapsedMicroseconds() * 1000.0 / PROBES;
+    }
+    return times;
+}
+
+// Probe policy comparison: the mixed workload on the fast probe and on the
+// oblivious probe, plus the average latency of gets that hit and gets that
+// miss. The fast probe's hit/miss gap is the timing signal the oblivious
+// probe removes; the slowdown column is what that costs.
+template<typename K, size_t ValueSize>
+void runProbePolicyBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
+    std::vector<size_t> dataSizes = {100000, 1000000, 10000000};
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Probe policies: fast vs oblivious, " << ValueSize << "-byte value" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Data Size | Policy    | Mixed Ops Time (ms) | Avg Op Time (μs) | Hit Get (ns) | Miss Get (ns) | Slowdown |" << std::endl;
+    std::cout << "|-----------|-----------|---------------------|------------------|--------------|---------------|----------|" << std::endl;
+    
+    for (size_t dataSize : dataSizes) {
+        ProbeTimes fast = timeProbePolicy<K, ValueSize, DefaultKVStore>(dataSize, readRatio, numOperations);
+        ProbeTimes oblivious = timeProbePolicy<K, ValueSize, ObliviousKVStore>(dataSize, readRatio, numOperations);
+        for (bool isFast : {true, false}) {
+            const ProbeTimes& t = isFast ? fast : oblivious;
+            std::cout << "| " << std::setw(9) << dataSize << " | "
+                    << std::setw(9) << (isFast ? "fast" : "oblivious") << " | "
+                    << std::setw(19) << t.mixedMs << " | "
+                    << std::setw(16) << t.mixedMs * 1000.0 / numOperations << " | "
+                    << std::setw(12) << t.hitNs << " | "
+                    << std::setw(13) << t.missNs << " | "
+                    << std::setw(8) << t.mixedMs / fast.mixedMs << " |" << std::endl;
+        }
+    }
+}
+
+// Variable-length values: one VarKVStore per value-size distribution, loaded
+// with dataSize keys and then driven by the mixed workload, where every
+// update draws a new length from the same distribution. Payload bytes come
+// from a shared random pool, and all lengths are drawn before the timers
+// start. Overhead is total memory over live payload bytes.
+template<typename K>
+void runVariableValueBenchmark(const std::vector<ValueSizeDistribution>& distributions,
+                               double readRatio = DEFAULT_READ_RATIO, size_t dataSize = DEFAULT_DATA_SIZE,
+                               size_t numOperations = DEFAULT_OPERATIONS) {
+    constexpr size_t POOL_SLACK = 1 << 16;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Variable-length values: " << dataSize << " keys, inline up to "
+            << VarKVStore<K>::INLINE_MAX << " bytes" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Value Sizes                    | Avg Value (B) | Insertion Time (ms) | Avg Insert (μs) | Mixed Ops Time (ms) | Avg Op Time (μs) | Memory (MiB) | Overhead (x) |" << std::endl;
+    std::cout << "|--------------------------------|---------------|---------------------|-----------------|---------------------|------------------|--------------|--------------|" << std::endl;
+    
+    for (const ValueSizeDistribution& sizes : distributions) {
+        std::mt19937 gen(42);
+        std::vector<uint8_t> pool(sizes.maxSize() + POOL_SLACK);
+        for (auto& byte : pool) {
+            byte = static_cast<uint8_t>(gen());
+        }
+        auto draw = [&](std::vector<uint32_t>& lengths, std::vector<uint32_t>& offsets, size_t n) {
+            lengths.resize(n);
+            offsets.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                lengths[i] = static_cast<uint32_t>(sizes.sample(gen));
+                offsets[i] = static_cast<uint32_t>(gen() % POOL_SLACK);
+            }
+        };
+        std::vector<uint32_t> lengths, offsets;
+        draw(lengths, offsets, dataSize);
+        
+        warmupSystem();
+        auto kvStore = makeStore<VarKVStore<K>>(dataSize);
+        
+        Timer timer;
+        timer.start();
+        for (size_t i = 0; i < dataSize; i++) {
+            kvStore.insert(static_cast<K>(i), pool.data() + offsets[i], lengths[i]);
+        }
+        double insertTime = timer.elapsedMilliseconds();
+        
+        auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+        draw(lengths, offsets, numOperations);
+        std::vector<uint8_t> buffer;
+        volatile size_t sink = 0;
+        
+        timer.start();
+        for (size_t i = 0; i < operations.size(); i++) {
+            K key = static_cast<K>(operations[i].second);
+            if (operations[i].first == 0) {
+                kvStore.getInto(key, buffer);
+                sink = sink + buffer.size();
+            } else {
+                kvStore.update(key, pool.data() + offsets[i], lengths[i]);
+            }
+        }
+        double mixedTime = timer.elapsedMilliseconds();
+        
+        std::cout << "| " << std::setw(30) << sizes.describe() << " | "
+                << std::setw(13) << static_cast<double>(kvStore.payloadBytes()) / kvStore.size() << " | "
+                << std::setw(19) << insertTime << " | "
+                << std::setw(15) << insertTime * 1000.0 / dataSize << " | "
+                << std::setw(19) << mixedTime << " | "
+                << std::setw(16) << mixedTime * 1000.0 / numOperations << " | "
+                << std::setw(12) << kvStore.memoryUsage() / (1024.0 * 1024.0) << " | "
+                << std::setw(12) << static_cast<double>(kvStore.memoryUsage()) / kvStore.payloadBytes() << " |" << std::endl;
+    }
+}
+
+// Per-lookup latency of one engine, hits and misses recorded separately
+struct LookupTails {
+    LatencyRecorder hits;
+    LatencyRecorder misses;
+    size_t memoryBytes;
+};
+
+template<typename K, size_t ValueSize, template<typename, size_t> class Store>
+LookupTails timeLookupTails(size_t dataSize, double loadFactor, size_t lookups) {
+    warmupSystem();
+    Store<K, ValueSize> kvStore(dataSize, loadFactor, tableMemory);
+    std::mt19937 gen(42);
+    for (size_t i = 0; i < dataSize; i++) {
+        kvStore.insert(static_cast<K>(i), generateRandomData<ValueSize>(gen));
+    }
+    
+    // Same key distribution for hits and misses: misses are shifted past the
+    // loaded range
+    std::uniform_int_distribution<size_t> keyDis(0, dataSize - 1);
+    std::vector<K> probes(lookups);
+    for (auto& key : probes) {
+        key = static_cast<K>(keyDis(gen));
+    }
+    LookupTails tails{{}, {}, kvStore.memoryUsage()};
+    std::array<uint8_t, ValueSize> readBuffer{};
+    volatile uint8_t sink = 0;
+    for (bool hit : {true, false}) {
+        LatencyRecorder& latencies = hit ? tails.hits : tails.misses;
+        latencies.reserve(lookups);
+        K offset = static_cast<K>(hit ? 0 : dataSize);
+        for (K key : probes) {
+            uint64_t t0 = nowNanoseconds();
+            readValue(kvStore, key + offset, readBuffer, 0);
+            latencies.record(nowNanoseconds() - t0);
+            sink = sink + readBuffer[0];
+        }
+    }
+    return tails;
+}
+
+// Lookup tail latency: every lookup of a random key is timed on its own, on
+// the chained engine and on the cuckoo engine, for keys that hit and keys
+// that miss. Both tables are sized for the same max load factor. A chained
+// lookup scans one chain plus, for overflowed chains, the stash; a cuckoo
+// lookup compares the keys of at most two buckets. The timestamps around
+// each lookup (tens of ns) are included, and max is sensitive to
+// interrupts, so compare it across engines within one run.
+template<typename K, size_t ValueSize>
+void runLookupTailBenchmark(size_t lookups = DEFAULT_OPERATIONS) {
+    std::vector<size_t> dataSizes = {100000, 1000000, 10000000};
+    const double loadFactor = tableLoadFactor > 0.0 ? tableLoadFactor : 0.75;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Lookup tail latency: chain vs cuckoo, " << ValueSize << "-byte value, max load factor "
+            << std::setprecision(2) << loadFactor << ", " << lookups << " lookups per row" << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "| Data Size | Engine | Lookups | Avg (ns) | p50 (ns) | p99 (ns) | p99.9 (ns) | p99.99 (ns) | Max (ns) | Memory (MiB) |" << std::endl;
+    std::cout << "|-----------|--------|---------|----------|----------|----------|------------|-------------|----------|--------------|" << std::endl;
+    
+    for (size_t dataSize : dataSizes) {
+        LookupTails chain = timeLookupTails<K, ValueSize, DefaultKVStore>(dataSize, loadFactor, lookups);
+        LookupTails cuckoo = timeLookupTails<K, ValueSize, DefaultCuckooKVStore>(dataSize, loadFactor, lookups);
+        for (LookupTails* tails : {&chain, &cuckoo}) {
+            for (bool hit : {true, false}) {
+                LatencyRecorder& latencies = hit ? tails->hits : tails->misses;
+                std::cout << "| " << std::setw(9) << dataSize << " | "
+                        << std::setw(6) << (tails == &chain ? "chain" : "cuckoo") << " | "
+                        << std::setw(7) << (hit ? "hit" : "miss") << " | "
+                        << std::setw(8) << latencies.mean() << " | "
+                        << std::setw(8) << latencies.percentile(50) << " | "
+                        << std::setw(8) << latencies.percentile(99) << " | "
+                        << std::setw(10) << latencies.percentile(99.9) << " | "
+                        << std::setw(11) << latencies.percentile(99.99) << " | "
+                        << std::setw(8) << latencies.max() << " | "
+                        << std::setw(12) << tails->memoryBytes / (1024.0 * 1024.0) << " |" << std::endl;
+            }
+        }
+    }
+}
+
+// Two-choice bin store (BOLT's placement) against the chained engine: the
+// mixed workload at 1M and 10M keys, with c = 2, 4 and 8 keys per bin (the
+// DIVISOR of exp_validation/sim.cpp). Every access of the bin store moves
+// its key, so the max bin load is observed under the same churn the bound
+// is stated for. The chained store is sized for the --load-factor (0.75 by
+// default).
+template<typename K, size_t ValueSize>
+void runTwoChoiceBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
+    std::vector<size_t> dataSizes = {1000000, 10000000};
+    const double loadFactor = tableLoadFactor > 0.0 ? tableLoadFactor : 0.75;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Two-choice bins vs chaining, " << ValueSize << "-byte value" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Data Size | Store        | Bins     | Bound  | Bin Slots | Max Bin Load | Full Choices | Mixed Ops Time (ms) | Throughput (Mops/s) | Memory (MiB) |" << std::endl;
+    std::cout << "|-----------|--------------|----------|--------|-----------|--------------|--------------|---------------------|---------------------|--------------|" << std::endl;
+    
+    for (size_t dataSize : dataSizes) {
+        auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+        std::mt19937 gen(42);
+        std::vector<std::array<uint8_t, ValueSize>> values(dataSize);
+        for (auto& value : values) {
+            value = generateRandomData<ValueSize>(gen);
+        }
+        
+        // Times the mixed workload on a loaded store
+        auto runMixed = [&](auto& kvStore) {
+            std::array<uint8_t, ValueSize> readBuffer{};
+            volatile uint8_t sink = 0;
+            Timer timer;
+            timer.start();
+            for (size_t i = 0; i < operations.size(); i++) {
+                K key = static_cast<K>(operations[i].second);
+                if (operations[i].first == 0) {
+                    kvStore.getInto(key, readBuffer.data());
+                    sink = sink + readBuffer[0];
+                } else {
+                    kvStore.update(key, values[i % dataSize]);
+                }
+            }
+            return timer.elapsedMilliseconds();
+        };
+        
+        {
+            warmupSystem();
+            DefaultKVStore<K, ValueSize> kvStore(dataSize, loadFactor, tableMemory);
+            for (size_t i = 0; i < dataSize; i++) {
+                kvStore.insert(static_cast<K>(i), values[i]);
+            }
+            double mixedMs = runMixed(kvStore);
+            std::cout << "| " << std::setw(9) << dataSize << " | "
+                    << std::setw(12) << "chain" << " | "
+                    << std::setw(8) << "-" << " | " << std::setw(6) << "-" << " | "
+                    << std::setw(9) << "-" << " | " << std::setw(12) << "-" << " | "
+                    << std::setw(12) << "-" << " | "
+                    << std::setw(19) << mixedMs << " | "
+                    << std::setw(19) << numOperations / (mixedMs * 1000.0) << " | "
+                    << std::setw(12) << kvStore.memoryUsage() / (1024.0 * 1024.0) << " |" << std::endl;
+        }
+        for (size_t keysPerBin : {2, 4, 8}) {
+            warmupSystem();
+            TwoChoiceKVStore<K, ValueSize> kvStore(dataSize, tableMemory, keysPerBin);
+            for (size_t i = 0; i < dataSize; i++) {
+                kvStore.insert(static_cast<K>(i), values[i]);
+            }
+            double mixedMs = runMixed(kvStore);
+            auto stats = kvStore.binStats();
+            std::cout << "| " << std::setw(9) << dataSize << " | "
+                    << std::setw(12) << ("2-choice c=" + std::to_string(keysPerBin)) << " | "
+                    << std::setw(8) << stats.bins << " | "
+                    << std::setw(6) << std::setprecision(2) << stats.bound << std::setprecision(3) << " | "
+                    << std::setw(9) << stats.binSlots << " | "
+                    << std::setw(12) << stats.maxLoad << " | "
+                    << std::setw(12) << stats.fullChoices << " | "
+                    << std::setw(19) << mixedMs << " | "
+                    << std::setw(19) << numOperations / (mixedMs * 1000.0) << " | "
+                    << std::setw(12) << kvStore.memoryUsage() / (1024.0 * 1024.0) << " |" << std::endl;
+        }
+    }
+}
+
+// Two-tier store (BOLT's HBM/host split) at the hot-tier shares of
+// hbm_distribution_experiment (1%, 20%, 50%), with the chained engine as the
+// all-in-one-tier baseline. Each operation of the mixed workload is timed on
+// its own; hot reads is the share of accesses served from the hot tier, which
+// tracks the ratio since every access re-places its key. The chained store
+// is sized for the --load-factor (0.75 by default).
+template<typename K, size_t ValueSize>
+void runTieredBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
+    std::vector<size_t> dataSizes = {1000000, 10000000};
+    const double loadFactor = tableLoadFactor > 0.0 ? tableLoadFactor : 0.75;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Hot/cold tiers vs chaining, " << ValueSize << "-byte value" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "| Data Size | Store      | Hot Tier (MiB) | Hot Reads (%) | Avg (ns) | p50 (ns) | p99 (ns) | p99.9 (ns) | Memory (MiB) |" << std::endl;
+    std::cout << "|-----------|------------|----------------|---------------|----------|----------|----------|------------|--------------|" << std::endl;
+    
+    for (size_t dataSize : dataSizes) {
+        auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+        std::mt19937 gen(42);
+        std::vector<std::array<uint8_t, ValueSize>> values(dataSize);
+        for (auto& value : values) {
+            value = generateRandomData<ValueSize>(gen);
+        }
+        
+        // Times each operation of the mixed workload on a loaded store
+        auto runMixed = [&](auto& kvStore) {
+            LatencyRecorder latencies;
+            latencies.reserve(operations.size());
+            std::array<uint8_t, ValueSize> readBuffer{};
+            volatile uint8_t sink = 0;
+            for (size_t i = 0; i < operations.size(); i++) {
+                K key = static_cast<K>(operations[i].second);
+                uint64_t t0 = nowNanoseconds();
+                if (operations[i].first == 0) {
+                    kvStore.getInto(key, readBuffer.data());
+                } else {
+                    kvStore.update(key, values[i % dataSize]);
+                }
+                latencies.record(nowNanoseconds() - t0);
+                sink = sink + readBuffer[0];
+            }
+            return latencies;
+        };
+        
+        auto printRow = [&](const std::string& store, double hotMiB, double hotReads, LatencyRecorder& latencies,
+                            size_t memoryBytes) {
+            std::cout << "| " << std::setw(9) << dataSize << " | "
+                    << std::setw(10) << store << " | "
+                    << std::setw(14) << hotMiB << " | "
+                    << std::setw(13) << hotReads << " | "
+                    << std::setw(8) << latencies.mean() << " | "
+                    << std::setw(8) << latencies.percentile(50) << " | "
+                    << std::setw(8) << latencies.percentile(99) << " | "
+                    << std::setw(10) << latencies.percentile(99.9) << " | "
+                    << std::setw(12) << memoryBytes / (1024.0 * 1024.0) << " |" << std::endl;
+        };
+        
+        {
+            warmupSystem();
+            DefaultKVStore<K, ValueSize> kvStore(dataSize, loadFactor, tableMemory);
+            for (size_t i = 0; i < dataSize; i++) {
+                kvStore.insert(static_cast<K>(i), values[i]);
+            }
+            LatencyRecorder latencies = runMixed(kvStore);
+            printRow("chain", kvStore.memoryUsage() / (1024.0 * 1024.0), 100.0, latencies, kvStore.memoryUsage());
+        }
+        for (double hotRatio : {0.01, 0.2, 0.5}) {
+            warmupSystem();
+            TieredKVStore<K, ValueSize> kvStore(dataSize, hotRatio, tableMemory);
+            for (size_t i = 0; i < dataSize; i++) {
+                kvStore.insert(static_cast<K>(i), values[i]);
+            }
+            auto before = kvStore.tierStats();
+            LatencyRecorder latencies = runMixed(kvStore);
+            auto after = kvStore.tierStats();
+            size_t hotReads = after.hotReads - before.hotReads;
+            size_t reads = hotReads + after.coldReads - before.coldReads;
+            printRow("tiered " + std::to_string(static_cast<int>(hotRatio * 100 + 0.5)) + "%",
+                     after.hotSlots * ValueSize / (1024.0 * 1024.0), 100.0 * hotReads / std::max<size_t>(reads, 1),
+                     latencies, kvStore.memoryUsage());
+        }
+    }
+}
+
+// Frozen store against the chained engine on a read-mostly workload (pass a
+// read ratio of 0.95 or more). The frozen store is loaded into its delta and
+// frozen once, timed on its own; then both stores run the mixed workload, in
+// which one write in WRITES_PER_INSERT inserts a new key (into the delta of
+// the frozen store) and the others update existing keys in place. The
+// chained store is sized for the --load-factor (0.75 by default).
+template<typename K, size_t ValueSize>
+void runFrozenBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
+    constexpr size_t WRITES_PER_INSERT = 16;
+    std::vector<size_t> dataSizes = {1000000, 10000000};
+    const double loadFactor = tableLoadFactor > 0.0 ? tableLoadFactor : 0.75;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Frozen perfect hash vs chaining, " << ValueSize << "-byte value" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Data Size | Store  | Freeze (ms) | Pilot Bits/Key | Mixed Ops Time (ms) | Throughput (Mops/s) | Delta Keys | Memory (MiB) |" << std::endl;
+    std::cout << "|-----------|--------|-------------|----------------|---------------------|---------------------|------------|--------------|" << std::endl;
+    
+    for (size_t dataSize : dataSizes) {
+        auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+        std::mt19937 gen(42);
+        std::vector<std::array<uint8_t, ValueSize>> values(dataSize);
+        for (auto& value : values) {
+            value = generateRandomData<ValueSize>(gen);
+        }
+        
+        // Times the mixed workload on a loaded store
+        auto runMixed = [&](auto& kvStore) {
+            std::array<uint8_t, ValueSize> readBuffer{};
+            volatile uint8_t sink = 0;
+            size_t writes = 0;
+            Timer timer;
+            timer.start();
+            for (size_t i = 0; i < operations.size(); i++) {
+                K key = static_cast<K>(operations[i].second);
+                if (operations[i].first == 0) {
+                    kvStore.getInto(key, readBuffer.data());
+                    sink = sink + readBuffer[0];
+                } else if (++writes % WRITES_PER_INSERT == 0) {
+                    kvStore.insert(static_cast<K>(dataSize + i), values[i % dataSize]);
+                } else {
+                    kvStore.update(key, values[i % dataSize]);
+                }
+            }
+            return timer.elapsedMilliseconds();
+        };
+        
+        {
+            warmupSystem();
+            DefaultKVStore<K, ValueSize> kvStore(dataSize, loadFactor, tableMemory);
+            for (size_t i = 0; i < dataSize; i++) {
+                kvStore.insert(static_cast<K>(i), values[i]);
+            }
+            double mixedMs = runMixed(kvStore);
+            std::cout << "| " << std::setw(9) << dataSize << " | "
+                    << std::setw(6) << "chain" << " | "
+                    << std::setw(11) << "-" << " | " << std::setw(14) << "-" << " | "
+                    << std::setw(19) << mixedMs << " | "
+                    << std::setw(19) << numOperations / (mixedMs * 1000.0) << " | "
+                    << std::setw(10) << "-" << " | "
+                    << std::setw(12) << kvStore.memoryUsage() / (1024.0 * 1024.0) << " |" << std::endl;
+        }
+        {
+            warmupSystem();
+            FrozenKVStore<K, ValueSize> kvStore(dataSize, tableMemory);
+            for (size_t i = 0; i < dataSize; i++) {
+                kvStore.insert(static_cast<K>(i), values[i]);
+            }
+            Timer timer;
+            timer.start();
+            kvStore.freeze();
+            double freezeMs = timer.elapsedMilliseconds();
+            double mixedMs = runMixed(kvStore);
+            auto stats = kvStore.freezeStats();
+            std::cout << "| " << std::setw(9) << dataSize << " | "
+                    << std::setw(6) << "frozen" << " | "
+                    << std::setw(11) << freezeMs << " | "
+                    << std::setw(14) << stats.pilotBits << " | "
+                    << std::setw(19) << mixedMs << " | "
+                    << std::setw(19) << numOperations / (mixedMs * 1000.0) << " | "
+                    << std::setw(10) << stats.deltaKeys << " | "
+                    << std::setw(12) << kvStore.memoryUsage() / (1024.0 * 1024.0) << " |" << std::endl;
+        }
+    }
+}
+
+// Nanoseconds per key to hash keys (and reduce to one of chains chains
+// unless reduce is false), rounds times over. Batched hashes each group of
+// 32 keys with hashBatch before reducing, as multiGet does; otherwise every
+// key is hashed on its own. chains is read through a volatile so the
+// modulo is a real division, as in the store.
+template<typename Hash, typename Range>
+double timeHashing(const std::vector<int>& keys, size_t rounds, size_t chains, bool batched, bool reduce,
+                   uint64_t& sink) {
+    constexpr size_t GROUP = 32;
+    volatile size_t chainsRead = chains;
+    size_t n = chainsRead;
+    uint64_t acc = 0;
+    uint64_t hashes[GROUP];
+    uint64_t t0 = nowNanoseconds();
+    for (size_t round = 0; round < rounds; ++round) {
+        for (size_t base = 0; base < keys.size(); base += GROUP) {
+            size_t group = std::min(GROUP, keys.size() - base);
+            if (batched) {
+                Hash::hashBatch(keys.data() + base, group, hashes);
+            } else {
+                for (size_t i = 0; i < group; ++i) {
+                    hashes[i] = Hash::hash(static_cast<uint64_t>(keys[base + i]));
+                }
+            }
+            for (size_t i = 0; i < group; ++i) {
+                acc += reduce ? Range::index(hashes[i], n) : hashes[i];
+            }
+        }
+    }
+    double ns = static_cast<double>(nowNanoseconds() - t0);
+    sink += acc;
+    return ns / (static_cast<double>(rounds) * keys.size());
+}
+
+// Hashing cost on its own and in the store. The first table hashes an
+// L1-resident array of keys over and over, so only the hash and the range
+// reduction are timed: each hash policy, one key at a time and in batches,
+// alone and followed by each range policy. The second runs the mixed
+// workload at 1M and 10M keys on stores built with the same policies,
+// sized for the --load-factor (0.75 by default).
+template<size_t ValueSize>
+void runHashBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t numOperations = DEFAULT_OPERATIONS) {
+    using K = int;
+    constexpr size_t KEYS = 4096;
+    constexpr size_t ROUNDS = 16384; // 64M keys per row
+    const double loadFactor = tableLoadFactor > 0.0 ? tableLoadFactor : 0.75;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Hashing and range reduction, batch path: "
+            << (HASH_BATCH_LANES > 1 ? std::to_string(HASH_BATCH_LANES) + " keys per vector"
+                                     : std::string("scalar (build with -mavx2 or -march=native)"))
+            << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::mt19937 gen(42);
+    std::vector<K> keys(KEYS);
+    for (K& key : keys) {
+        key = static_cast<K>(gen());
+    }
+    const size_t chains = 1000000;
+    uint64_t sink = 0;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Hash      | Path   | Range           | ns/key | Mkeys/s  |" << std::endl;
+    std::cout << "|-----------|--------|-----------------|--------|----------|" << std::endl;
+    auto hashRows = [&](auto hashPolicy, const char* hashName) {
+        using Hash = decltype(hashPolicy);
+        for (bool batched : {false, true}) {
+            auto row = [&](const char* rangeName, double ns) {
+                std::cout << "| " << std::setw(9) << hashName << " | "
+                        << std::setw(6) << (batched ? "batch" : "scalar") << " | "
+                        << std::setw(15) << rangeName << " | "
+                        << std::setw(6) << ns << " | "
+                        << std::setw(8) << 1000.0 / ns << " |" << std::endl;
+            };
+            row("none", timeHashing<Hash, PrimeModulo>(keys, ROUNDS, chains, batched, false, sink));
+            row("prime modulo", timeHashing<Hash, PrimeModulo>(keys, ROUNDS, PrimeModulo::chainCount(chains),
+                                                               batched, true, sink));
+            row("fastrange", timeHashing<Hash, FastRange>(keys, ROUNDS, FastRange::chainCount(chains),
+                                                          batched, true, sink));
+            row("power-of-2 mask", timeHashing<Hash, PowerOfTwoMask>(keys, ROUNDS, PowerOfTwoMask::chainCount(chains),
+                                                                     batched, true, sink));
+        }
+    };
+    hashRows(Murmur3Hash{}, "murmur3");
+    hashRows(FibonacciHash{}, "fibonacci");
+    if (sink == 1) {
+        std::cout << std::endl; // Keeps the hashes live
+    }
+    
+    std::cout << "\nMixed workload, " << ValueSize << "-byte value, read/write ratio: "
+            << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "| Data Size | Hash      | Range           | Mixed Ops Time (ms) | Throughput (Mops/s) | Memory (MiB) |" << std::endl;
+    std::cout << "|-----------|-----------|-----------------|---------------------|---------------------|--------------|" << std::endl;
+    
+    for (size_t dataSize : {1000000, 10000000}) {
+        auto operations = generateRandomOperations(numOperations, dataSize, readRatio);
+        std::vector<std::array<uint8_t, ValueSize>> values(dataSize);
+        for (auto& value : values) {
+            value = generateRandomData<ValueSize>(gen);
+        }
+        
+        auto storeRow = [&](auto hashPolicy, auto rangePolicy, const char* hashName, const char* rangeName) {
+            using Hash = decltype(hashPolicy);
+            using Range = decltype(rangePolicy);
+            warmupSystem();
+            KVStore<K, ValueSize, HashedKVStoreTraits<K, ValueSize, Hash, Range>> kvStore(dataSize, loadFactor,
+                                                                                          tableMemory);
+            for (size_t i = 0; i < dataSize; i++) {
+                kvStore.insert(static_cast<K>(i), values[i]);
+            }
+            std::array<uint8_t, ValueSize> readBuffer{};
+            volatile uint8_t readSink = 0;
+            Timer timer;
+            timer.start();
+            for (size_t i = 0; i < operations.size(); i++) {
+                K key = static_cast<K>(operations[i].second);
+                if (operations[i].first == 0) {
+                    kvStore.getInto(key, readBuffer.data());
+                    readSink = readSink + readBuffer[0];
+                } else {
+                    kvStore.update(key, values[i % dataSize]);
+                }
+            }
+            double mixedMs = timer.elapsedMilliseconds();
+            std::cout << "| " << std::setw(9) << dataSize << " | "
+                    << std::setw(9) << hashName << " | "
+                    << std::setw(15) << rangeName << " | "
+                    << std::setw(19) << mixedMs << " | "
+                    << std::setw(19) << numOperations / (mixedMs * 1000.0) << " | "
+                    << std::setw(12) << kvStore.memoryUsage() / (1024.0 * 1024.0) << " |" << std::endl;
+        };
+        storeRow(Murmur3Hash{}, PrimeModulo{}, "murmur3", "prime modulo");
+        storeRow(Murmur3Hash{}, FastRange{}, "murmur3", "fastrange");
+        storeRow(Murmur3Hash{}, PowerOfTwoMask{}, "murmur3", "power-of-2 mask");
+        storeRow(FibonacciHash{}, FastRange{}, "fibonacci", "fastrange");
+    }
+}
+
+// Drive a started sharded store: load dataSize keys through client 0, then
+// let every client issue opsPerClient operations (uniform or Zipf keys) with
+// up to CLIENT_WINDOW requests in flight, client c pinned to clientCores[c].
+// Latency is measured per request from submission to the client seeing the
+// reply, so it includes queueing in both rings. Stops the store and returns
+// the elapsed time of the measured phase (ms), the merged latencies and each
+// shard's counters for that phase.
+template<typename K, size_t ValueSize, typename Sharded>
+double runShardedClients(Sharded& store, size_t dataSize, size_t opsPerClient, double readRatio, bool zipf,
+                         const std::vector<size_t>& clientCores, LatencyRecorder& all,
+                         std::vector<typename Sharded::ShardStats>& phase) {
+    using ValueType = std::array<uint8_t, ValueSize>;
+    constexpr size_t CLIENT_WINDOW = 64;
+    constexpr size_t VALUE_POOL = 1024;
+    size_t clientCount = store.clientCount();
+    size_t shardCount = store.shardCount();
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    
+    // Load through client 0
+    {
+        auto& loader = store.client(0);
+        std::mt19937 gen(42);
+        typename Sharded::Response replies[CLIENT_WINDOW];
+        for (size_t i = 0; i < dataSize;) {
+            if (loader.submit(Sharded::Op::Update, static_cast<K>(i), 0, generateRandomData<ValueSize>(gen))) {
+                i++;
+            } else {
+                loader.poll(replies, CLIENT_WINDOW);
+            }
+        }
+        while (loader.outstanding()) {
+            loader.poll(replies, CLIENT_WINDOW);
+        }
+    }
+    std::vector<typename Sharded::ShardStats> before(shardCount);
+    for (size_t s = 0; s < shardCount; s++) {
+        before[s] = store.shardStats(s);
+    }
+    
+    std::vector<std::vector<std::pair<int, int>>> operations(clientCount);
+    std::vector<std::vector<ValueType>> newValues(clientCount);
+    std::vector<LatencyRecorder> latency(clientCount);
+    std::mt19937 gen(7);
+    for (size_t c = 0; c < clientCount; c++) {
+        operations[c] = zipf ? generateZipfOperations(opsPerClient, dataSize, readRatio)
+                             : generateRandomOperations(opsPerClient, dataSize, readRatio);
+        newValues[c].resize(VALUE_POOL);
+        for (auto& value : newValues[c]) {
+            value = generateRandomData<ValueSize>(gen);
+        }
+        latency[c].reserve(opsPerClient);
+        store.client(c).setNode(NumaTopology::system().nodeOfCpu(clientCores[c] % cores));
+    }
+    
+    std::atomic<bool> go{false};
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < clientCount; c++) {
+        clients.emplace_back([&, c] {
+            auto& client = store.client(c);
+            std::vector<uint64_t> sentAt(opsPerClient);
+            typename Sharded::Response replies[CLIENT_WINDOW];
+            size_t next = 0;
+            size_t done = 0;
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            while (done < opsPerClient) {
+                while (next < opsPerClient && client.outstanding() < CLIENT_WINDOW) {
+                    const auto& operation = operations[c][next];
+                    auto op = operation.first == 0 ? Sharded::Op::Get : Sharded::Op::Update;
+                    sentAt[next] = nowNanoseconds();
+                    if (!client.submit(op, static_cast<K>(operation.second), static_cast<uint32_t>(next),
+                                       newValues[c][next % VALUE_POOL])) {
+                        break;
+                    }
+                    next++;
+                }
+                size_t n = client.poll(replies, CLIENT_WINDOW);
+                uint64_t now = nowNanoseconds();
+                for (size_t i = 0; i < n; i++) {
+                    latency[c].record(now - sentAt[replies[i].tag]);
+                }
+                done += n;
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        pinThreadToCore(clients.back(), clientCores[c]);
+    }
+    
+    Timer timer;
+    timer.start();
+    go.store(true, std::memory_order_release);
+    for (auto& client : clients) {
+        client.join();
+    }
+    double ms = timer.elapsedMilliseconds();
+    store.stop();
+    
+    for (const auto& recorder : latency) {
+        all.merge(recorder);
+    }
+    phase.resize(shardCount);
+    for (size_t s = 0; s < shardCount; s++) {
+        auto stats = store.shardStats(s);
+        phase[s] = {stats.requests - before[s].requests, stats.batches - before[s].batches,
+                    stats.localRequests - before[s].localRequests, stats.remoteRequests - before[s].remoteRequests};
+    }
+    return ms;
+}
+
+// Shared-nothing sharding: shards run the store on their own (pinned)
+// threads and clients reach them through SPSC rings, each keeping up to 64
+// requests in flight. Imbalance is the busiest shard's request count over
+// the mean.
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
+void runShardedBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t dataSize = DEFAULT_DATA_SIZE,
+                         size_t opsPerClient = DEFAULT_OPERATIONS) {
+    using Sharded = ShardedKVStore<Store<K, ValueSize>>;
+    
+    size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t shardCount = std::max<size_t>(2, hardwareThreads / 2);
+    size_t clientCount = std::max<size_t>(2, hardwareThreads - hardwareThreads / 2);
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "Shared-nothing sharding: " << shardCount << " shards, " << clientCount << " clients, "
+            << dataSize << " keys, " << ValueSize << "-byte value" << std::endl;
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "Hardware threads: " << hardwareThreads << ", 64 requests in flight per client" << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Keys     | Throughput (Mops/s) | p50 (μs) | p99 (μs) | p99.9 (μs) | Imbalance | Avg Batch | Requests per Shard |" << std::endl;
+    std::cout << "|----------|---------------------|----------|----------|------------|-----------|-----------|--------------------|" << std::endl;
+    
+    std::vector<size_t> clientCores(clientCount);
+    for (size_t c = 0; c < clientCount; c++) {
+        clientCores[c] = c;
+    }
+    
+    for (const char* distribution : {"uniform", "zipf"}) {
+        warmupSystem();
+        size_t keysPerShard = dataSize / shardCount + 1;
+        std::unique_ptr<Sharded> store = tableLoadFactor > 0.0
+            ? std::make_unique<Sharded>(shardCount, clientCount, keysPerShard, tableLoadFactor)
+            : std::make_unique<Sharded>(shardCount, clientCount, keysPerShard * 2);
+        store->start(clientCount);
+        
+        LatencyRecorder all;
+        std::vector<typename Sharded::ShardStats> phase;
+        bool zipf = std::string(distribution) == "zipf";
+        double ms = runShardedClients<K, ValueSize>(*store, dataSize, opsPerClient, readRatio, zipf,
+                                                    clientCores, all, phase);
+        
+        uint64_t maxRequests = 0;
+        uint64_t totalRequests = 0;
+        uint64_t totalBatches = 0;
+        std::string perShard;
+        for (size_t s = 0; s < shardCount; s++) {
+            maxRequests = std::max(maxRequests, phase[s].requests);
+            totalRequests += phase[s].requests;
+            totalBatches += phase[s].batches;
+            perShard += (s ? " / " : "") + std::to_string(phase[s].requests);
+        }
+        double imbalance = totalRequests ? maxRequests * static_cast<double>(shardCount) / totalRequests : 0.0;
+        
+        std::cout << "| " << std::setw(8) << distribution << " | "
+                << std::setw(19) << clientCount * opsPerClient / (ms * 1000.0) << " | "
+                << std::setw(8) << all.percentile(50) / 1000.0 << " | "
+                << std::setw(8) << all.percentile(99) / 1000.0 << " | "
+                << std::setw(10) << all.percentile(99.9) / 1000.0 << " | "
+                << std::setw(9) << imbalance << " | "
+                << std::setw(9) << (totalBatches ? static_cast<double>(totalRequests) / totalBatches : 0.0) << " | "
+                << perShard << " |" << std::endl;
+    }
+}
+
+// NUMA placement: shards spread node by node as in ShardedKVStore's NUMA
+// constructor, once with all their memory on the first node (what a store
+// first touched by one thread gets) and once with each shard's memory bound
+// to its own node. Clients are spread evenly over the nodes. A request is
+// local when its client runs on the shard's node; a memory access is local
+// when the shard's data is bound to the node its thread runs on (counted
+// once per request).
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultKVStore>
+void runNumaBenchmark(double readRatio = DEFAULT_READ_RATIO, size_t dataSize = DEFAULT_DATA_SIZE,
+                      size_t opsPerClient = DEFAULT_OPERATIONS) {
+    using Sharded = ShardedKVStore<Store<K, ValueSize>>;
+    
+    const NumaTopology& topology = NumaTopology::system();
+    size_t nodes = topology.nodeCount();
+    size_t smallestNode = topology.node(0).cpus.size();
+    for (size_t n = 1; n < nodes; n++) {
+        smallestNode = std::min(smallestNode, topology.node(n).cpus.size());
+    }
+    // Half of each node's CPUs run shards, the other half clients
+    size_t shardsPerNode = std::max<size_t>(1, smallestNode / 2);
+    size_t clientsPerNode = std::max<size_t>(1, smallestNode - smallestNode / 2);
+    size_t shardCount = shardsPerNode * nodes;
+    size_t clientCount = clientsPerNode * nodes;
+    
+    std::cout << "\n==========================================================" << std::endl;
+    std::cout << "NUMA placement: " << nodes << " node(s), " << shardsPerNode << " shard(s) and "
+            << clientsPerNode << " client(s) per node, " << dataSize << " keys, " << ValueSize << "-byte value" << std::endl;
+    for (size_t n = 0; n < nodes; n++) {
+        std::cout << "Node " << topology.node(n).id << ": " << topology.node(n).cpus.size() << " CPU(s)" << std::endl;
+    }
+    std::cout << "Read/Write Ratio: " << readRatio << " / " << (1.0 - readRatio) << std::endl;
+    std::cout << "----------------------------------------------------------" << std::endl;
+    
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "| Placement    | Throughput (Mops/s) | p50 (μs) | p99 (μs) | Local Requests | Remote Requests | Local Memory | Remote Memory |" << std::endl;
+    std::cout << "|--------------|---------------------|----------|----------|----------------|-----------------|--------------|---------------|" << std::endl;
+    
+    // Clients take the CPUs of each node after the ones its shards use
+    std::vector<size_t> clientCores;
+    for (size_t n = 0; n < nodes; n++) {
+        const auto& cpus = topology.node(n).cpus;
+        for (size_t i = 0; i < clientsPerNode; i++) {
+            clientCores.push_back(cpus[(shardsPerNode + i) % cpus.size()]);
+        }
+    }
+    
+    size_t keysPerShard = dataSize / shardCount + 1;
+    double loadFactor = tableLoadFactor > 0.0 ? tableLoadFactor : 0.75;
+    int firstNode = topology.node(0).id;
+    
+    for (bool placed : {false, true}) {
+        warmupSystem();
+        TableMemoryPolicy memory = tableMemory;
+        memory.numaNode = placed ? -1 : firstNode;
+        auto store = std::make_unique<Sharded>(topology, shardsPerNode, clientCount, memory, keysPerShard, loadFactor);
+        store->start();
+        
+        LatencyRecorder all;
+        std::vector<typename Sharded::ShardStats> phase;
+        double ms = runShardedClients<K, ValueSize>(*store, dataSize, opsPerClient, readRatio, false,
+                                                    clientCores, all, phase);
+        
+        uint64_t localRequests = 0, remoteRequests = 0, localMemory = 0, remoteMemory = 0;
+        for (size_t s = 0; s < shardCount; s++) {
+            localRequests += phase[s].localRequests;
+            remoteRequests += phase[s].remoteRequests;
+            int memoryNode = placed ? store->shardNode(s) : firstNode;
+            (memoryNode == store->shardNode(s) ? localMemory : remoteMemory) += phase[s].requests;
+        }
+        
+        std::cout << "| " << std::setw(12) << (placed ? "per node" : "first node") << " | "
+                << std::setw(19) << clientCount * opsPerClient / (ms * 1000.0) << " | "
+                << std::setw(8) << all.percentile(50) / 1000.0 << " | "
+                << std::setw(8) << all.percentile(99) / 1000.0 << " | "
+                << std::setw(14) << localRequests << " | "
+                << std::setw(15) << remoteRequests << " | "
+                << std::setw(12) << localMemory << " | "
+                << std::setw(13) << remoteMemory << " |" << std::endl;
+    }
+}
+
+// Concurrency stress test: threads hammer a small key range with updates,
+// removes and gets. Every value written carries its key followed by one
+// repeated stamp byte, so a torn or misattributed read is detected; at the
+// end every key is checked again and the live keys are counted against
+// size().
+template<typename K, size_t ValueSize, template<typename, size_t> class Store = DefaultConcurrentKVStore>
+bool runConcurrencyStressTest(size_t threads, size_t keyRange = 4096, size_t opsPerThread = 1000000) {
+    using ValueType = std::array<uint8_t, ValueSize>;
+    static_assert(ValueSize > sizeof(K), "values carry their key plus at least one stamp byte");
+    
+    auto makeValue = [](K key, uint8_t stamp) {
+        ValueType value;
+        value.fill(stamp);
+        std::memcpy(value.data(), &key, sizeof(K));
+        return value;
+    };
+    auto wellFormed = [](K key, const ValueType& value) {
+        if (std::memcmp(value.data(), &key, sizeof(K)) != 0) {
+            return false;
+        }
+        return std::all_of(value.begin() + sizeof(K), value.end(),
+                           [&](uint8_t b) { return b == value[sizeof(K)]; });
+    };
+    
+    std::cout << "Stress: " << threads << " threads, " << keyRange << " keys, "
+            << ValueSize << "-byte value, " << opsPerThread << " ops per thread... " << std::flush;
+    
+    auto kvStore = makeStore<Store<K, ValueSize>>(keyRange / 4);
+    std::atomic<size_t> corrupt{0};
+    std::atomic<size_t> hits{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937 gen(static_cast<unsigned>(t + 1));
+            std::uniform_int_distribution<size_t> keyDis(0, keyRange - 1);
+            size_t localCorrupt = 0;
+            size_t localHits = 0;
+            for (size_t i = 0; i < opsPerThread; i++) {
+                K key = static_cast<K>(keyDis(gen));
+                unsigned op = gen() % 10;
+                if (op < 4) {
+                    kvStore.update(key, makeValue(key, static_cast<uint8_t>(gen())));
+                } else if (op == 4) {
+                    kvStore.remove(key);
+                } else {
+                    ValueType value;
+                    if (kvStore.get(key, &value)) {
+                        localHits++;
+                        localCorrupt += !wellFormed(key, value);
+                    }
+                }
+            }
+            corrupt += localCorrupt;
+            hits += localHits;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    size_t live = 0;
+    for (size_t k = 0; k < keyRange; k++) {
+        K key = static_cast<K>(k);
+        ValueType value;
+        if (kvStore.get(key, &value)) {
+            live++;
+            corrupt += !wellFormed(key, value);
+        }
+    }
+    
+    bool passed = corrupt == 0 && live == kvStore.size();
+    std::cout << (passed ? "PASS" : "FAIL") << " (" << hits << " concurrent hits, " << corrupt
+            << " corrupt reads, " << live << " live keys, size() " << kvStore.size() << ")" << std::endl;
+    return passed;
+}
+
+// Standard benchmark suite (i)-(iii) against one store instantiation
+template<template<typename, size_t> class Store>
+void runStandardBenchmarks(double readRatio) {
+    // Benchmark (i): Fixed 1M data, 8-byte value
+    runFixedSizeBenchmark<int, 8, Store>(readRatio);
+    
+    // Benchmark (ii): Variable data size with fixed 8-byte value
+    runVaryingDataSizeBenchmark<int, 8, Store>(readRatio);
+    
+    // Benchmark (iii): Fixed 1M data with varying value sizes
+    runVaryingValueSizeBenchmark<int, Store>(readRatio);
+}
+
+// Run the benchmark mode selected on the command line
+template<template<typename, size_t> class Store>
+void runSelectedBenchmarks(const std::string& mode, double readRatio) {
+    if (mode == "growth") {
+        runGrowthBenchmark<int, 8, Store>();
+    } else if (mode == "coro") {
+        runInterleavedBenchmark<int, 8, Store>(readRatio);
+        runInterleavedBenchmark<int, 8, Store>(readRatio, 10000000);
+    } else if (mode == "sharded") {
+        runShardedBenchmark<int, 8, Store>(readRatio);
+    } else if (mode == "numa") {
+        runNumaBenchmark<int, 8, Store>(readRatio);
+    } else if (mode == "oblivious") {
+        runProbePolicyBenchmark<int, 8>(readRatio);
+        runProbePolicyBenchmark<int, 64>(readRatio);
+    } else if (mode == "bins") {
+        runTwoChoiceBenchmark<int, 8>(readRatio);
+    } else if (mode == "hash") {
+        runHashBenchmark<8>(readRatio);
+    } else if (mode == "frozen") {
+        runFrozenBenchmark<int, 8>(readRatio);
+    } else if (mode == "tiers") {
+        runTieredBenchmark<int, 8>(readRatio);
+    } else if (mode == "tail") {
+        runLookupTailBenchmark<int, 8>();
+        runLookupTailBenchmark<int, 64>();
+    } else if (mode == "varsize") {
+        std::vector<ValueSizeDistribution> distributions = valueSizeDistributions;
+        if (distributions.empty()) {
+            for (const char* spec : {"fixed:8", "uniform:1-64", "uniform:16-1024", "lognormal:128,1.0",
+                                     "mix:8@0.6,128@0.3,4096@0.1"}) {
+                distributions.push_back(ValueSizeDistribution::parse(spec));
+            }
+        }
+        runVariableValueBenchmark<int>(distributions, readRatio);
+    } else if (mode == "stress") {
+        std::cout << "\n==========================================================" << std::endl;
+        std::cout << "Concurrency stress test" << std::endl;
+        std::cout << "----------------------------------------------------------" << std::endl;
+        size_t threads = std::max<size_t>(8, std::thread::hardware_concurrency());
+        bool passed = runConcurrencyStressTest<int, 8, Store>(threads);
+        passed &= runConcurrencyStressTest<int, 256, Store>(threads);
+        passed &= runConcurrencyStressTest<int, 8, Store>(threads, 64);
+        if (!passed) {
+            std::exit(1);
+        }
+    } else if (mode == "threads") {
+        runThreadScalingBenchmark<int, 8, Store>(readRatio);
+        runThreadScalingBenchmark<int, 256, Store>(readRatio);
+    } else if (mode == "batch") {
+        runBatchSweepBenchmark<int, 8, Store>(readRatio);
+        runBatchSweepBenchmark<int, 8, Store>(readRatio, 10000000);
+    } else {
+        runStandardBenchmarks<Store>(readRatio);
+    }
 }
 
 int main(int argc, char* argv[]) {
     // Default read ratio
     double readRatio = DEFAULT_READ_RATIO;
+    std::string storage = "default";
+    std::string engine = "chain";
+    std::string layout = "sparse";
+    std::string mode = "standard";
+    bool readRatioSet = false;
     
-    // Parse read ratio from command line if provided
-    if (argc > 1) {
-        try {
-            readRatio = std::stod(argv[1]);
-            if (readRatio < 0.0 || readRatio > 1.0) {
-                std::cerr << "Read ratio must be between 0.0 and 1.0" << std::endl;
+    // Parse flags and the optional positional read ratio
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--storage=", 0) == 0) {
+            storage = arg.substr(10);
+            if (storage != "default" && storage != "indirect") {
+                std::cerr << "Unknown value storage: " << storage << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--engine=", 0) == 0) {
+            engine = arg.substr(9);
+            if (engine != "chain" && engine != "swiss" && engine != "cuckoo" && engine != "concurrent" &&
+                engine != "epoch") {
+                std::cerr << "Unknown engine: " << engine << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--mode=", 0) == 0) {
+            mode = arg.substr(7);
+            if (mode != "standard" && mode != "growth" && mode != "batch" && mode != "coro" &&
+                mode != "threads" && mode != "stress" && mode != "sharded" && mode != "numa" &&
+                mode != "oblivious" && mode != "varsize" && mode != "tail" && mode != "bins" &&
+                mode != "tiers" && mode != "frozen" &&
+                mode != "hash") {
+                std::cerr << "Unknown mode: " << mode << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--layout=", 0) == 0) {
+            layout = arg.substr(9);
+            if (layout != "sparse" && layout != "compact") {
+                std::cerr << "Unknown layout: " << layout << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--load-factor=", 0) == 0) {
+            try {
+                tableLoadFactor = std::stod(arg.substr(14));
+            } catch (const std::exception& e) {
+                tableLoadFactor = -1.0;
+            }
+            if (tableLoadFactor <= 0.0 || tableLoadFactor > 1.0) {
+                std::cerr << "Load factor must be in (0.0, 1.0]" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--huge-pages=", 0) == 0) {
+            std::string pages = arg.substr(13);
+            if (pages == "off") {
+                tableMemory.hugePages = HugePages::Off;
+            } else if (pages == "thp") {
+                tableMemory.hugePages = HugePages::Transparent;
+            } else if (pages == "explicit") {
+                tableMemory.hugePages = HugePages::Explicit;
+            } else {
+                std::cerr << "Unknown huge page mode: " << pages << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--value-sizes=", 0) == 0) {
+            try {
+                valueSizeDistributions.push_back(ValueSizeDistribution::parse(arg.substr(14)));
+            } catch (const std::invalid_argument& e) {
+                std::cerr << e.what() << std::endl;
                 return 1;
             }
-        } catch (const std::exception& e) {
-            std::cerr << "Invalid read ratio: " << argv[1] << std::endl;
+        } else if (arg == "--prefault") {
+            tableMemory.prefault = true;
+        } else if (arg == "--bulk-load") {
+            bulkLoadInitialData = true;
+        } else if (arg.rfind("--snapshot=", 0) == 0) {
+            snapshotPrefix = arg.substr(11);
+            if (snapshotPrefix.empty()) {
+                std::cerr << "--snapshot needs a file prefix" << std::endl;
+                return 1;
+            }
+        } else if (!readRatioSet) {
+            try {
+                readRatio = std::stod(arg);
+                if (readRatio < 0.0 || readRatio > 1.0) {
+                    std::cerr << "Read ratio must be between 0.0 and 1.0" << std::endl;
+                    return 1;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid read ratio: " << arg << std::endl;
+                return 1;
+            }
+            readRatioSet = true;
+        } else {
+            std::cerr << "Unexpected argument: " << arg << std::endl;
             return 1;
         }
     }
     
+    if (layout == "compact" && (engine != "chain" || storage != "default")) {
+        std::cerr << "--layout=compact applies to the chain engine and picks its own value storage" << std::endl;
+        return 1;
+    }
+    
+    if (mode == "oblivious" && (engine != "chain" || layout != "sparse" || storage != "default")) {
+        std::cerr << "--mode=oblivious compares the probe policies of the default chain engine" << std::endl;
+        return 1;
+    }
+    if (mode == "bins" && (engine != "chain" || layout != "sparse" || storage != "default")) {
+        std::cerr << "--mode=bins compares the two-choice bin store with the default chain engine" << std::endl;
+        return 1;
+    }
+    if (mode == "hash" && (engine != "chain" || layout != "sparse" || storage != "default")) {
+        std::cerr << "--mode=hash compares hash and range policies of the default chain engine" << std::endl;
+        return 1;
+    }
+    if (mode == "frozen" && (engine != "chain" || layout != "sparse" || storage != "default")) {
+        std::cerr << "--mode=frozen compares the frozen store with the default chain engine" << std::endl;
+        return 1;
+    }
+    if (mode == "tiers" && (engine != "chain" || layout != "sparse" || storage != "default")) {
+        std::cerr << "--mode=tiers compares the two-tier store with the default chain engine" << std::endl;
+        return 1;
+    }
+    if (mode == "tail" && (engine != "chain" || layout != "sparse" || storage != "default")) {
+        std::cerr << "--mode=tail compares the default chain and cuckoo engines" << std::endl;
+        return 1;
+    }
+    if (mode == "varsize" && (engine != "chain" || layout != "sparse" || storage != "default")) {
+        std::cerr << "--mode=varsize indexes values through the default chain engine" << std::endl;
+        return 1;
+    }
+    if (!valueSizeDistributions.empty() && mode != "varsize") {
+        std::cerr << "--value-sizes applies to --mode=varsize" << std::endl;
+        return 1;
+    }
+    if (mode == "numa" && engine != "chain") {
+        std::cerr << "--mode=numa binds table memory, which only the chain engine supports" << std::endl;
+        return 1;
+    }
+    if ((mode == "threads" || mode == "stress") && engine != "concurrent" && engine != "epoch") {
+        std::cerr << "--mode=" << mode << " needs a thread-safe engine (--engine=concurrent or --engine=epoch)" << std::endl;
+        return 1;
+    }
+    if (engine == "epoch" && storage != "default") {
+        std::cerr << "--engine=epoch always keeps values in their own nodes" << std::endl;
+        return 1;
+    }
+    
     std::cout << "KV Store Benchmarks" << std::endl;
     std::cout << "===================" << std::endl;
     
-    // Benchmark (i): Fixed 1M data, 8-byte value
-    runFixedSizeBenchmark<int, 8>(readRatio);
-    
-    // Benchmark (ii): Variable data size with fixed 8-byte value
-    runVaryingDataSizeBenchmark<int, 8>(readRatio);
+    std::cout << "Engine: " << engine << ", layout: " << layout << ", value storage: " << storage;
+    if (tableLoadFactor > 0.0) {
+        std::cout << ", max load factor: " << tableLoadFactor;
+    }
+    if (tableMemory.hugePages != HugePages::Off || tableMemory.prefault) {
+        std::cout << ", huge pages: " << hugePagesName(tableMemory.hugePages);
+        if (tableMemory.prefault) {
+            std::cout << " (prefaulted)";
+        }
+    }
+    if (bulkLoadInitialData) {
+        std::cout << ", initial data bulk-loaded";
+    }
+    if (!snapshotPrefix.empty()) {
+        std::cout << ", snapshots: " << snapshotPrefix << ".*.kvsnap";
+    }
+    std::cout << std::endl;
     
-    // Benchmark (iii): Fixed 1M data with varying value sizes
-    runVaryingValueSizeBenchmark<int>(readRatio);
+    if (engine == "swiss") {
+        if (storage == "indirect") {
+            runSelectedBenchmarks<IndirectSwissKVStore>(mode, readRatio);
+        } else {
+            runSelectedBenchmarks<DefaultSwissKVStore>(mode, readRatio);
+        }
+    } else if (engine == "cuckoo") {
+        if (storage == "indirect") {
+            runSelectedBenchmarks<IndirectCuckooKVStore>(mode, readRatio);
+        } else {
+            runSelectedBenchmarks<DefaultCuckooKVStore>(mode, readRatio);
+        }
+    } else if (engine == "epoch") {
+        runSelectedBenchmarks<DefaultEpochKVStore>(mode, readRatio);
+    } else if (engine == "concurrent") {
+        if (storage == "indirect") {
+            runSelectedBenchmarks<IndirectConcurrentKVStore>(mode, readRatio);
+        } else {
+            runSelectedBenchmarks<DefaultConcurrentKVStore>(mode, readRatio);
+        }
+    } else if (layout == "compact") {
+        runSelectedBenchmarks<CompactKVStore>(mode, readRatio);
+    } else {
+        if (storage == "indirect") {
+            runSelectedBenchmarks<IndirectKVStore>(mode, readRatio);
+        } else {
+            runSelectedBenchmarks<DefaultKVStore>(mode, readRatio);
+        }
+    }
     
     return 0;
 }
\ No newline at end of file
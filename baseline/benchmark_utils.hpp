@@ -8,6 +8,18 @@
 #include <iomanip>
 #include <utility>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 // Helper function to generate random data of any size
 template<size_t Size>
@@ -26,7 +38,7 @@ void printHexData(const std::array<uint8_t, Size>& value) {
     for (uint8_t byte : value) {
         std::cout << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
     }
-    std::cout << std::dec;
+    std::cout << std::dec << std::setfill(' ');
 }
 
 // Generate random operations (0 = get, 1 = update)
@@ -45,6 +57,184 @@ inline std::vector<std::pair<int, int>> generateRandomOperations(size_t numOpera
     return operations;
 }
 
+// Generate operations whose keys follow a Zipf distribution (YCSB's
+// generator): key 0 is the most popular, and theta close to 1 concentrates
+// most of the traffic on a few keys
+inline std::vector<std::pair<int, int>> generateZipfOperations(size_t numOperations, size_t dataSize,
+                                                              double readRatio = 0.5, double theta = 0.99) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_real_distribution<> unit(0.0, 1.0);
+    
+    double zetan = 0.0;
+    for (size_t i = 1; i <= dataSize; i++) {
+        zetan += 1.0 / std::pow(static_cast<double>(i), theta);
+    }
+    double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+    double alpha = 1.0 / (1.0 - theta);
+    double eta = (1.0 - std::pow(2.0 / dataSize, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    
+    std::vector<std::pair<int, int>> operations(numOperations);
+    for (size_t i = 0; i < numOperations; i++) {
+        int op = (unit(gen) < readRatio) ? 0 : 1; // 0 for get, 1 for update
+        double u = unit(gen);
+        double uz = u * zetan;
+        size_t key;
+        if (uz < 1.0) {
+            key = 0;
+        } else if (uz < zeta2) {
+            key = 1;
+        } else {
+            key = static_cast<size_t>(dataSize * std::pow(eta * u - eta + 1.0, alpha));
+        }
+        operations[i] = {op, static_cast<int>(std::min(key, dataSize - 1))};
+    }
+    
+    return operations;
+}
+
+// Value-size distribution for variable-length workloads, parsed from one of
+//   fixed:N                 every value is N bytes
+//   uniform:MIN-MAX         uniform over [MIN, MAX]
+//   lognormal:MEDIAN,SIGMA  log-normal with the given median and log-space
+//                           sigma (heavy right tail), clamped to [1, MAX_SIZE]
+//   mix:S1@W1,S2@W2,...     S_i bytes with probability proportional to W_i
+class ValueSizeDistribution {
+public:
+    static constexpr size_t MAX_SIZE = 1 << 20;
+
+private:
+    enum class Kind { Fixed, Uniform, LogNormal, Mix };
+
+    Kind kind = Kind::Fixed;
+    size_t low = 0;
+    size_t high = 0;
+    double mu = 0.0;
+    double sigma = 0.0;
+    std::vector<size_t> sizes;
+    std::vector<double> cumulative; // Running sum of the mix weights
+    std::string spec;
+
+    static size_t parseSize(const std::string& text, const std::string& spec) {
+        size_t end = 0;
+        unsigned long long value = 0;
+        try {
+            value = std::stoull(text, &end);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != text.size() || value > MAX_SIZE) {
+            throw std::invalid_argument("bad value size '" + text + "' in " + spec);
+        }
+        return static_cast<size_t>(value);
+    }
+
+    static double parseReal(const std::string& text, const std::string& spec) {
+        size_t end = 0;
+        double value = 0.0;
+        try {
+            value = std::stod(text, &end);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != text.size() || !(value >= 0.0)) {
+            throw std::invalid_argument("bad number '" + text + "' in " + spec);
+        }
+        return value;
+    }
+
+public:
+    // Throws std::invalid_argument on a malformed spec
+    static ValueSizeDistribution parse(const std::string& spec) {
+        ValueSizeDistribution d;
+        d.spec = spec;
+        size_t colon = spec.find(':');
+        std::string kind = spec.substr(0, colon);
+        std::string args = colon == std::string::npos ? "" : spec.substr(colon + 1);
+        if (kind == "fixed") {
+            d.kind = Kind::Fixed;
+            d.low = d.high = parseSize(args, spec);
+        } else if (kind == "uniform") {
+            size_t dash = args.find('-');
+            if (dash == std::string::npos) {
+                throw std::invalid_argument("expected uniform:MIN-MAX, got " + spec);
+            }
+            d.kind = Kind::Uniform;
+            d.low = parseSize(args.substr(0, dash), spec);
+            d.high = parseSize(args.substr(dash + 1), spec);
+            if (d.low > d.high) {
+                throw std::invalid_argument("empty range in " + spec);
+            }
+        } else if (kind == "lognormal") {
+            size_t comma = args.find(',');
+            if (comma == std::string::npos) {
+                throw std::invalid_argument("expected lognormal:MEDIAN,SIGMA, got " + spec);
+            }
+            d.kind = Kind::LogNormal;
+            d.mu = std::log(std::max(1.0, parseReal(args.substr(0, comma), spec)));
+            d.sigma = parseReal(args.substr(comma + 1), spec);
+        } else if (kind == "mix") {
+            d.kind = Kind::Mix;
+            double total = 0.0;
+            size_t start = 0;
+            while (start <= args.size()) {
+                size_t comma = args.find(',', start);
+                std::string item = args.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                size_t at = item.find('@');
+                if (at == std::string::npos) {
+                    throw std::invalid_argument("expected SIZE@WEIGHT, got '" + item + "' in " + spec);
+                }
+                d.sizes.push_back(parseSize(item.substr(0, at), spec));
+                total += parseReal(item.substr(at + 1), spec);
+                d.cumulative.push_back(total);
+                if (comma == std::string::npos) {
+                    break;
+                }
+                start = comma + 1;
+            }
+            if (!(total > 0.0)) {
+                throw std::invalid_argument("mix weights must not all be zero in " + spec);
+            }
+        } else {
+            throw std::invalid_argument("unknown value-size distribution " + spec);
+        }
+        return d;
+    }
+
+    size_t sample(std::mt19937& gen) const {
+        switch (kind) {
+            case Kind::Fixed:
+                return low;
+            case Kind::Uniform:
+                return std::uniform_int_distribution<size_t>(low, high)(gen);
+            case Kind::LogNormal: {
+                double size = std::lognormal_distribution<double>(mu, sigma)(gen);
+                return static_cast<size_t>(std::clamp(std::round(size), 1.0, static_cast<double>(MAX_SIZE)));
+            }
+            case Kind::Mix: {
+                double u = std::uniform_real_distribution<double>(0.0, cumulative.back())(gen);
+                size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+                return sizes[std::min(i, sizes.size() - 1)];
+            }
+        }
+        return low;
+    }
+
+    // Largest size sample() can return
+    size_t maxSize() const {
+        switch (kind) {
+            case Kind::LogNormal:
+                return MAX_SIZE;
+            case Kind::Mix:
+                return *std::max_element(sizes.begin(), sizes.end());
+            default:
+                return high;
+        }
+    }
+
+    const std::string& describe() const { return spec; }
+};
+
 // Timer utility
 class Timer {
 private:
@@ -65,4 +255,141 @@ public:
     }
 };
 
+// Monotonic timestamp for per-operation latency measurement
+inline uint64_t nowNanoseconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Per-operation latency samples (nanoseconds) with percentile summaries
+class LatencyRecorder {
+private:
+    std::vector<uint64_t> samples;
+    bool sorted = true;
+    
+    void sort() {
+        if (!sorted) {
+            std::sort(samples.begin(), samples.end());
+            sorted = true;
+        }
+    }
+    
+public:
+    void reserve(size_t n) {
+        samples.reserve(n);
+    }
+    
+    void record(uint64_t ns) {
+        samples.push_back(ns);
+        sorted = false;
+    }
+    
+    // Append the samples of another recorder
+    void merge(const LatencyRecorder& other) {
+        samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+        sorted = samples.empty();
+    }
+    
+    size_t count() const {
+        return samples.size();
+    }
+    
+    double mean() const {
+        if (samples.empty()) return 0.0;
+        double sum = 0.0;
+        for (uint64_t s : samples) {
+            sum += static_cast<double>(s);
+        }
+        return sum / samples.size();
+    }
+    
+    // Nearest-rank percentile, p in [0, 100]
+    uint64_t percentile(double p) {
+        if (samples.empty()) return 0;
+        sort();
+        size_t rank = static_cast<size_t>(p / 100.0 * samples.size());
+        return samples[std::min(rank, samples.size() - 1)];
+    }
+    
+    uint64_t max() {
+        if (samples.empty()) return 0;
+        sort();
+        return samples.back();
+    }
+};
+
+// Hardware event counter for the calling thread (user space only), read
+// through perf_event_open. Opening fails without kernel support or
+// permission (perf_event_paranoid, containers, most VMs); available() then
+// returns false and stop() returns 0.
+class PerfCounter {
+private:
+    int fd = -1;
+    
+public:
+    // Data-TLB load misses
+    static PerfCounter dtlbLoadMisses() {
+#ifdef __linux__
+        return PerfCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                               (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#else
+        return PerfCounter(0, 0);
+#endif
+    }
+    
+    PerfCounter(uint32_t type, uint64_t config) {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)type;
+        (void)config;
+#endif
+    }
+    
+    PerfCounter(PerfCounter&& other) noexcept : fd(std::exchange(other.fd, -1)) {}
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+    
+    ~PerfCounter() {
+#ifdef __linux__
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+    
+    bool available() const { return fd >= 0; }
+    
+    void start() {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    
+    // Events counted since start()
+    uint64_t stop() {
+        uint64_t events = 0;
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &events, sizeof(events)) != static_cast<ssize_t>(sizeof(events))) {
+                events = 0;
+            }
+        }
+#endif
+        return events;
+    }
+};
+
 #endif // BENCHMARK_UTILS_HPP
\ No newline at end of file
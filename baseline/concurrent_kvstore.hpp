@@ -0,0 +1,318 @@
+#ifndef CONCURRENT_KV_STORE_HPP
+#define CONCURRENT_KV_STORE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "kvstore.hpp"
+#include "simd_match.hpp"
+#include "table_memory.hpp"
+
+// Thread-safe chained KV store. Every chain carries a sequence counter that
+// is odd while a writer is inside it:
+//  - writers take the chain by moving the counter from even to odd with a
+//    CAS (so the counter doubles as a per-chain write lock) and release it
+//    by bumping it to the next even value;
+//  - readers take no lock: they copy the key's value out, then re-read the
+//    counter and retry if it changed or was odd (a seqlock), so a copy torn
+//    by a concurrent writer is never returned, whatever the value size.
+// A key whose chain is full, or an insert past the load factor, grows the
+// table: the grower locks every chain of the current table, rehashes into a
+// table twice the size and publishes it. Chains of a retired table stay
+// locked, which sends readers and writers to the new one; the retired
+// tables themselves are kept until the store is destroyed because lock-free
+// readers may still be probing them (together they are smaller than the
+// live table).
+template<typename K, size_t ValueSize, typename Traits = KVStoreTraits<K, ValueSize>>
+class ConcurrentKVStore {
+private:
+    static constexpr size_t CHAIN_SIZE = Traits::ChainSize;
+    static_assert(CHAIN_SIZE >= 1 && CHAIN_SIZE <= 32, "chain occupancy is a 32-bit mask");
+    static constexpr double DEFAULT_MAX_LOAD_FACTOR = 0.75;
+    static constexpr uint32_t FULL_MASK = CHAIN_SIZE == 32 ? ~0u : (1u << CHAIN_SIZE) - 1;
+    static constexpr unsigned SPINS_BEFORE_YIELD = 64;
+
+    using Storage = typename Traits::Storage;
+
+    struct alignas(64) Chain {
+        std::atomic<uint32_t> version; // Odd while a writer holds the chain
+        uint32_t occupied;             // Bit i set when slot i holds a key
+        std::array<K, CHAIN_SIZE> keys;
+        std::array<Storage, CHAIN_SIZE> values;
+
+        uint32_t find(K key) const {
+            return matchKeyMask<K, CHAIN_SIZE>(keys.data(), key) & occupied & FULL_MASK;
+        }
+    };
+
+    struct Table {
+        ZeroedArray<Chain> chains;
+        size_t size;
+
+        explicit Table(size_t size) : chains(size), size(size) {}
+
+        Chain& chainFor(uint64_t h) { return chains[Traits::Range::index(h, size)]; }
+    };
+
+    std::atomic<Table*> current{nullptr};
+    std::vector<std::unique_ptr<Table>> tables; // Live table last; guarded by growthMutex
+    std::mutex growthMutex;
+    std::atomic<size_t> count{0};
+    double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
+
+    // Out-of-line value slots are shared by all chains; only inserts of new
+    // keys and removals touch the allocator
+    typename Storage::Arena valueArena;
+    std::mutex arenaMutex;
+
+    static uint64_t hash(K key) {
+        return Traits::Hash::hash(static_cast<uint64_t>(key));
+    }
+
+    // Busy-wait a little, then give the core away so a preempted writer can
+    // finish
+    static void backoff(unsigned& spins) {
+        if (++spins < SPINS_BEFORE_YIELD) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            spins = 0;
+            std::this_thread::yield();
+        }
+    }
+
+    // The release fence after the odd version keeps the writer's stores to
+    // the chain from becoming visible before it (the seqlock writer side)
+    static bool tryLock(Chain& chain, uint32_t& version) {
+        version = chain.version.load(std::memory_order_relaxed);
+        if ((version & 1) ||
+            !chain.version.compare_exchange_weak(version, version + 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+
+    static void unlock(Chain& chain, uint32_t version) {
+        chain.version.store(version + 2, std::memory_order_release);
+    }
+
+    // Lock the chain of h in the live table; returns the chain and the even
+    // version it was taken at. Holding a chain of a table means no growth has
+    // retired that table yet.
+    Chain& lockChain(uint64_t h, uint32_t& version) {
+        unsigned spins = 0;
+        for (;;) {
+            Chain& chain = current.load(std::memory_order_acquire)->chainFor(h);
+            if (tryLock(chain, version)) {
+                return chain;
+            }
+            backoff(spins);
+        }
+    }
+
+    // Grow past the table the caller saw, unless someone already has
+    void grow(Table* seen) {
+        std::lock_guard<std::mutex> guard(growthMutex);
+        Table* old = current.load(std::memory_order_relaxed);
+        if (old != seen) {
+            return;
+        }
+
+        // Lock out every writer; the chains are never unlocked again
+        for (size_t i = 0; i < old->size; ++i) {
+            uint32_t version;
+            unsigned spins = 0;
+            while (!tryLock(old->chains[i], version)) {
+                backoff(spins);
+            }
+        }
+
+        // Entries are copied, not moved, so a table that turns out too small
+        // can simply be dropped and rebuilt bigger
+        for (size_t size = Traits::Range::chainCount(old->size * 2);; size = Traits::Range::chainCount(size * 2)) {
+            auto fresh = std::make_unique<Table>(size);
+            if (rehashInto(*old, *fresh)) {
+                current.store(fresh.get(), std::memory_order_release);
+                tables.push_back(std::move(fresh));
+                return;
+            }
+        }
+    }
+
+    static bool rehashInto(Table& from, Table& to) {
+        for (size_t i = 0; i < from.size; ++i) {
+            const Chain& src = from.chains[i];
+            for (uint32_t m = src.occupied; m; m &= m - 1) {
+                size_t slot = __builtin_ctz(m);
+                Chain& dst = to.chainFor(hash(src.keys[slot]));
+                if ((dst.occupied & FULL_MASK) == FULL_MASK) {
+                    return false;
+                }
+                size_t free = __builtin_ctz(~dst.occupied);
+                dst.keys[free] = src.keys[slot];
+                dst.values[free] = src.values[slot];
+                dst.occupied |= 1u << free;
+            }
+        }
+        return true;
+    }
+
+    void store(K key, const std::array<uint8_t, ValueSize>& value) {
+        uint64_t h = hash(key);
+        for (;;) {
+            uint32_t version;
+            Chain& chain = lockChain(h, version);
+            Table* table = current.load(std::memory_order_relaxed);
+
+            if (uint32_t hits = chain.find(key)) {
+                // In place: the existing value (or its out-of-line slot) is reused
+                chain.values[__builtin_ctz(hits)].write(value, valueArena);
+                unlock(chain, version);
+                return;
+            }
+
+            bool full = (chain.occupied & FULL_MASK) == FULL_MASK;
+            if (full || count.load(std::memory_order_relaxed) + 1 > maxLoadFactor * table->size * CHAIN_SIZE) {
+                unlock(chain, version);
+                grow(table);
+                continue;
+            }
+
+            Storage slot;
+            if constexpr (Storage::isIndirect) {
+                std::lock_guard<std::mutex> guard(arenaMutex);
+                slot.write(value, valueArena);
+            } else {
+                slot.write(value, valueArena);
+            }
+            size_t free = __builtin_ctz(~chain.occupied);
+            chain.keys[free] = key;
+            chain.values[free] = slot;
+            chain.occupied |= 1u << free;
+            count.fetch_add(1, std::memory_order_relaxed);
+            unlock(chain, version);
+            return;
+        }
+    }
+
+    void init(size_t chains) {
+        tables.push_back(std::make_unique<Table>(Traits::Range::chainCount(chains)));
+        current.store(tables.back().get(), std::memory_order_release);
+    }
+
+public:
+    using KeyType = K;
+    using ValueType = std::array<uint8_t, ValueSize>;
+
+    // Constructor that scales the table with the expected data size (1.5x
+    // chains, like KVStore)
+    ConcurrentKVStore(size_t dataSize = 1000000) {
+        init(static_cast<size_t>(dataSize * 1.5));
+    }
+
+    // Constructor that sizes the table so expectedKeys fill at most
+    // maxLoadFactor of all chain slots; the table grows past that
+    ConcurrentKVStore(size_t expectedKeys, double maxLoadFactor) : maxLoadFactor(maxLoadFactor) {
+        init(static_cast<size_t>(expectedKeys / (CHAIN_SIZE * maxLoadFactor)) + 1);
+    }
+
+    // Tables are referenced by address, so the store stays where it was built
+    ConcurrentKVStore(ConcurrentKVStore&& other) noexcept
+        : tables(std::move(other.tables)), count(other.count.load()), maxLoadFactor(other.maxLoadFactor),
+          valueArena(std::move(other.valueArena)) {
+        current.store(other.current.exchange(nullptr));
+    }
+
+    ConcurrentKVStore(const ConcurrentKVStore&) = delete;
+    ConcurrentKVStore& operator=(const ConcurrentKVStore&) = delete;
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // Bytes held by the live and retired tables plus out-of-line values.
+    // Not synchronized with a concurrent growth.
+    size_t memoryUsage() const {
+        size_t bytes = valueArena.capacityBytes();
+        for (const auto& table : tables) {
+            bytes += table->chains.capacityBytes();
+        }
+        return bytes;
+    }
+
+    // Copy key's value into *out; false (and *out untouched) if absent
+    bool get(K key, ValueType* out) const {
+        uint64_t h = hash(key);
+        unsigned spins = 0;
+        for (;;) {
+            const Chain& chain = current.load(std::memory_order_acquire)->chainFor(h);
+            uint32_t before = chain.version.load(std::memory_order_acquire);
+            if (before & 1) {
+                backoff(spins);
+                continue;
+            }
+
+            ValueType copy;
+            bool found = false;
+            if (uint32_t hits = chain.find(key)) {
+                const Storage& value = chain.values[__builtin_ctz(hits)];
+                if (value.hasValue()) {
+                    std::memcpy(copy.data(), value.address(), ValueSize);
+                    found = true;
+                }
+            }
+
+            // Order the copy before the re-check of the counter
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (chain.version.load(std::memory_order_relaxed) == before) {
+                if (found) {
+                    *out = copy;
+                }
+                return found;
+            }
+            backoff(spins);
+        }
+    }
+
+    ValueType get(K key) const {
+        ValueType result{};
+        get(key, &result);
+        return result;  // Return the found value or empty array if not found
+    }
+
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
+    }
+
+    bool remove(K key) {
+        uint32_t version;
+        Chain& chain = lockChain(hash(key), version);
+        uint32_t hits = chain.find(key);
+        if (hits) {
+            size_t slot = __builtin_ctz(hits);
+            if constexpr (Storage::isIndirect) {
+                std::lock_guard<std::mutex> guard(arenaMutex);
+                chain.values[slot].release(valueArena);
+            }
+            chain.values[slot] = Storage();
+            chain.occupied &= ~(1u << slot);
+            count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        unlock(chain, version);
+        return hits != 0;
+    }
+};
+
+#endif // CONCURRENT_KV_STORE_HPP
@@ -0,0 +1,408 @@
+#ifndef CUCKOO_KV_STORE_HPP
+#define CUCKOO_KV_STORE_HPP
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+#include "kvstore.hpp"
+#include "simd_match.hpp"
+#include "table_memory.hpp"
+
+// Bucketized cuckoo hash table. Every key has exactly two candidate buckets
+// (from the two halves of its hash) and lives in one of them or in a small
+// stash, so a lookup compares the keys of at most two buckets no matter how
+// full the table is. Each bucket keeps its keys and occupancy word in its
+// first cache line. An insert whose two buckets are full makes room with a
+// breadth-first search for the shortest chain of moves (at most
+// MAX_PATH_DEPTH) to a bucket with a free slot; when there is none the key is
+// stashed, and when the stash is full the table doubles. Exposes the same
+// get/insert/update/remove surface as KVStore.
+template<typename K, size_t ValueSize, typename Traits = KVStoreTraits<K, ValueSize>>
+class CuckooKVStore {
+private:
+    using Storage = typename Traits::Storage;
+
+    // As many slots as fit in a cache line, but 4 to 8: fewer makes the
+    // table fill poorly, more makes the key compare cross into a second line
+    static constexpr size_t BUCKET_SLOTS = std::clamp<size_t>(slotsPerCacheLine<K, Storage>(), 4, 8);
+    static constexpr size_t STASH_SIZE = 8;
+    static constexpr size_t MAX_PATH_DEPTH = 5;   // Keys moved by one insert, at most
+    static constexpr size_t MAX_SEARCH_NODES = 512; // Buckets the search visits, at most
+    static constexpr double DEFAULT_MAX_LOAD_FACTOR = 0.9; // Grow beyond this fill
+
+    // Same structure-of-arrays bucket as KVStore's chains: the keys are
+    // contiguous for a single vector compare, and all-zero bytes are empty
+    template<size_t N>
+    struct alignas(64) Bucket {
+        static constexpr uint32_t FULL_MASK = (1u << N) - 1;
+
+        std::array<K, N> keys;
+        uint32_t occupied; // Bit i set when slot i holds a key (bits >= N are flags)
+        std::array<Storage, N> values;
+
+        uint32_t slots() const { return occupied & FULL_MASK; }
+        bool full() const { return slots() == FULL_MASK; }
+
+        uint32_t find(K key) const {
+            return matchKeyMask<K, N>(keys.data(), key) & slots();
+        }
+
+        void place(size_t slot, K key, Storage&& value) {
+            keys[slot] = key;
+            values[slot] = std::move(value);
+            occupied |= 1u << slot;
+        }
+
+        void erase(size_t slot) {
+            values[slot] = Storage();
+            occupied &= ~(1u << slot);
+        }
+    };
+
+    using Slots = Bucket<BUCKET_SLOTS>;
+    using BucketTable = ZeroedArray<Slots>;
+
+    // Set on a key's first bucket when the key went to the stash, so only
+    // lookups through such buckets scan the stash. May stay set after the
+    // stash entry leaves; it is never missing.
+    static constexpr uint32_t OVERFLOW_BIT = 1u << 31;
+
+    // Node of the displacement search: a bucket reached by moving the key in
+    // slot parentSlot of the parent node's bucket
+    struct PathNode {
+        size_t bucket;
+        int parent;       // Index into the search queue, -1 for a candidate bucket
+        uint8_t parentSlot;
+        uint8_t depth;
+    };
+
+    TableMemoryPolicy memoryPolicy;
+    BucketTable table;
+    size_t bucketMask = 0;
+    typename Storage::Arena valueArena{memoryPolicy}; // Out-of-line value slots
+    size_t count = 0; // Live keys
+    double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
+
+    Bucket<STASH_SIZE> stash{};
+    size_t stashPeak = 0;
+    size_t stashOverflows = 0;
+
+    std::vector<PathNode> search; // Reused by every displacement search
+
+    static uint64_t hash(K key) {
+        return Traits::Hash::hash(static_cast<uint64_t>(key));
+    }
+
+    // The two candidate buckets come from the low and the high half of the
+    // hash and are always distinct
+    size_t firstBucket(uint64_t h) const { return h & bucketMask; }
+    size_t secondBucket(uint64_t h) const {
+        size_t b = (h >> 32) & bucketMask;
+        return b == firstBucket(h) ? b ^ 1 : b;
+    }
+
+    // The candidate bucket of key other than b
+    size_t alternateBucket(K key, size_t b) const {
+        uint64_t h = hash(key);
+        size_t first = firstBucket(h);
+        return b == first ? secondBucket(h) : first;
+    }
+
+    template<size_t N>
+    static size_t freeSlot(const Bucket<N>& bucket) {
+        return __builtin_ctz(~bucket.occupied);
+    }
+
+    const Storage* locate(K key, uint64_t h) const {
+        size_t b1 = firstBucket(h);
+        size_t b2 = secondBucket(h);
+        // Both lines are requested before the first compare waits on its own
+        __builtin_prefetch(&table[b2]);
+        const Slots& first = table[b1];
+        if (uint32_t hits = first.find(key)) {
+            return &first.values[__builtin_ctz(hits)];
+        }
+        const Slots& second = table[b2];
+        if (uint32_t hits = second.find(key)) {
+            return &second.values[__builtin_ctz(hits)];
+        }
+        if (first.occupied & OVERFLOW_BIT) {
+            if (uint32_t hits = stash.find(key)) {
+                return &stash.values[__builtin_ctz(hits)];
+            }
+        }
+        return nullptr;
+    }
+
+    Storage* locate(K key, uint64_t h) {
+        return const_cast<Storage*>(static_cast<const CuckooKVStore*>(this)->locate(key, h));
+    }
+
+    // True if bucket already lies on the path ending at node (moving a key
+    // back into a bucket it was moved out of could undo an earlier move)
+    bool onPath(int node, size_t bucket) const {
+        for (; node >= 0; node = search[node].parent) {
+            if (search[node].bucket == bucket) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Breadth-first search from both candidate buckets of h for the shortest
+    // chain of moves that ends in a free slot. If one is found the keys are
+    // moved, last move first, and the freed slot of a candidate bucket is
+    // returned in bucketOut/slotOut.
+    bool makeRoom(uint64_t h, size_t& bucketOut, size_t& slotOut) {
+        search.clear();
+        search.push_back({firstBucket(h), -1, 0, 0});
+        search.push_back({secondBucket(h), -1, 0, 0});
+        for (size_t next = 0; next < search.size(); ++next) {
+            PathNode node = search[next];
+            const Slots& bucket = table[node.bucket];
+            if (!bucket.full()) {
+                // Walk back to the candidate bucket, moving each key into the
+                // slot freed by the move after it
+                size_t slot = freeSlot(bucket);
+                int at = static_cast<int>(next);
+                while (search[at].parent >= 0) {
+                    const PathNode& child = search[at];
+                    Slots& from = table[search[child.parent].bucket];
+                    table[child.bucket].place(slot, from.keys[child.parentSlot],
+                                              std::move(from.values[child.parentSlot]));
+                    from.occupied &= ~(1u << child.parentSlot);
+                    slot = child.parentSlot;
+                    at = child.parent;
+                }
+                bucketOut = search[at].bucket;
+                slotOut = slot;
+                return true;
+            }
+            if (node.depth == MAX_PATH_DEPTH) {
+                continue;
+            }
+            for (size_t slot = 0; slot < BUCKET_SLOTS && search.size() < MAX_SEARCH_NODES; ++slot) {
+                size_t alt = alternateBucket(bucket.keys[slot], node.bucket);
+                if (!onPath(static_cast<int>(next), alt)) {
+                    search.push_back({alt, static_cast<int>(next), static_cast<uint8_t>(slot),
+                                      static_cast<uint8_t>(node.depth + 1)});
+                }
+            }
+        }
+        return false;
+    }
+
+    // Put a key known to be absent into its buckets, displacing other keys
+    // if needed, or into the stash; false if neither has room
+    bool place(K key, uint64_t h, Storage&& value) {
+        Slots& first = table[firstBucket(h)];
+        if (!first.full()) {
+            first.place(freeSlot(first), key, std::move(value));
+            return true;
+        }
+        Slots& second = table[secondBucket(h)];
+        if (!second.full()) {
+            second.place(freeSlot(second), key, std::move(value));
+            return true;
+        }
+        size_t bucket, slot;
+        if (makeRoom(h, bucket, slot)) {
+            table[bucket].place(slot, key, std::move(value));
+            return true;
+        }
+        if (stash.full()) {
+            return false;
+        }
+        stash.place(freeSlot(stash), key, std::move(value));
+        first.occupied |= OVERFLOW_BIT;
+        stashOverflows++;
+        stashPeak = std::max(stashPeak, static_cast<size_t>(__builtin_popcount(stash.slots())));
+        return true;
+    }
+
+    void allocate(size_t buckets) {
+        size_t n = 2;
+        while (n < buckets) {
+            n <<= 1;
+        }
+        table = BucketTable(n, memoryPolicy);
+        bucketMask = n - 1;
+        search.reserve(MAX_SEARCH_NODES);
+    }
+
+    // Rehash every key into a table of at least buckets buckets, doubling
+    // until all of them fit
+    void rehash(size_t buckets) {
+        std::vector<std::pair<K, Storage>> entries;
+        entries.reserve(count);
+        for (size_t b = 0; b <= bucketMask; ++b) {
+            const Slots& bucket = table[b];
+            for (uint32_t m = bucket.slots(); m; m &= m - 1) {
+                entries.emplace_back(bucket.keys[__builtin_ctz(m)], bucket.values[__builtin_ctz(m)]);
+            }
+        }
+        for (uint32_t m = stash.slots(); m; m &= m - 1) {
+            entries.emplace_back(stash.keys[__builtin_ctz(m)], stash.values[__builtin_ctz(m)]);
+        }
+        for (;; buckets *= 2) {
+            allocate(buckets);
+            stash = {};
+            bool placed = true;
+            for (auto& [key, value] : entries) {
+                // Storage copies share an out-of-line slot; only the copy
+                // that ends up in the table is kept
+                if (!place(key, hash(key), Storage(value))) {
+                    placed = false;
+                    break;
+                }
+            }
+            if (placed) {
+                return;
+            }
+        }
+    }
+
+    // Pull stashed keys back into their buckets once one of them has room
+    void drainStash() {
+        for (uint32_t m = stash.slots(); m; m &= m - 1) {
+            size_t slot = __builtin_ctz(m);
+            uint64_t h = hash(stash.keys[slot]);
+            for (size_t b : {firstBucket(h), secondBucket(h)}) {
+                Slots& bucket = table[b];
+                if (!bucket.full()) {
+                    bucket.place(freeSlot(bucket), stash.keys[slot], std::move(stash.values[slot]));
+                    stash.occupied &= ~(1u << slot);
+                    break;
+                }
+            }
+        }
+    }
+
+    void store(K key, const std::array<uint8_t, ValueSize>& value) {
+        uint64_t h = hash(key);
+        if (Storage* slot = locate(key, h)) {
+            slot->write(value, valueArena);
+            return;
+        }
+
+        if (count + 1 > maxLoadFactor * capacity()) {
+            rehash(2 * (bucketMask + 1));
+        }
+        Storage slot;
+        slot.write(value, valueArena);
+        while (!place(key, h, Storage(slot))) {
+            rehash(2 * (bucketMask + 1));
+        }
+        count++;
+    }
+
+    size_t capacity() const { return (bucketMask + 1) * BUCKET_SLOTS; }
+
+public:
+    using KeyType = K;
+    using ValueType = std::array<uint8_t, ValueSize>;
+
+    // Constructor that sizes the table for dataSize keys at the default
+    // max load factor
+    CuckooKVStore(size_t dataSize = 1000000, const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory), valueArena(memory) {
+        allocate(static_cast<size_t>(dataSize / (BUCKET_SLOTS * maxLoadFactor)) + 1);
+    }
+
+    // Constructor that sizes the table so expectedKeys fill at most
+    // maxLoadFactor of the slots; the table grows past that
+    CuckooKVStore(size_t expectedKeys, double maxLoadFactor, const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory), valueArena(memory), maxLoadFactor(maxLoadFactor) {
+        allocate(static_cast<size_t>(expectedKeys / (BUCKET_SLOTS * maxLoadFactor)) + 1);
+    }
+
+    size_t size() const { return count; }
+
+    // Stash occupancy counters, same shape as KVStore's
+    struct StashStats {
+        size_t size;      // Keys currently in the stash
+        size_t capacity;  // Stash slots
+        size_t peak;      // Highest occupancy seen
+        size_t overflows; // Keys ever stashed because no displacement path was found
+    };
+
+    StashStats stashStats() const {
+        return {static_cast<size_t>(__builtin_popcount(stash.slots())), STASH_SIZE, stashPeak, stashOverflows};
+    }
+
+    // Bytes held by the bucket table plus the slabs of out-of-line values
+    size_t memoryUsage() const {
+        return table.capacityBytes() + sizeof(stash) + valueArena.capacityBytes();
+    }
+
+    HugePages tablePageBacking() const { return table.pageBacking(); }
+
+    ValueType get(K key) const {
+        const Storage* value = locate(key, hash(key));
+        if (value && value->hasValue()) {
+            return value->read();
+        }
+        return ValueType{};  // Empty array if not found
+    }
+
+    // Copy the value of key to dst (ValueSize bytes); false, leaving dst
+    // alone, if key is absent
+    bool getInto(K key, uint8_t* dst) const {
+        const Storage* value = locate(key, hash(key));
+        if (!value || !value->hasValue()) {
+            return false;
+        }
+        std::memcpy(dst, value->read().data(), ValueSize);
+        return true;
+    }
+
+    // Call f(const ValueType&) on the value of key in place; false without
+    // calling f if key is absent. f must not modify the store.
+    template<typename F>
+    bool visit(K key, F&& f) const {
+        const Storage* value = locate(key, hash(key));
+        if (!value || !value->hasValue()) {
+            return false;
+        }
+        std::forward<F>(f)(value->read());
+        return true;
+    }
+
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+
+    bool remove(K key) {
+        uint64_t h = hash(key);
+        Slots& first = table[firstBucket(h)];
+        Slots& second = table[secondBucket(h)];
+        if (uint32_t hits = first.find(key)) {
+            first.values[__builtin_ctz(hits)].release(valueArena);
+            first.erase(__builtin_ctz(hits));
+        } else if (uint32_t hits = second.find(key)) {
+            second.values[__builtin_ctz(hits)].release(valueArena);
+            second.erase(__builtin_ctz(hits));
+        } else if (uint32_t stashHits = (first.occupied & OVERFLOW_BIT) ? stash.find(key) : 0) {
+            stash.values[__builtin_ctz(stashHits)].release(valueArena);
+            stash.erase(__builtin_ctz(stashHits));
+        } else {
+            return false;
+        }
+        count--;
+        if (stash.slots()) {
+            drainStash();
+        }
+        return true;
+    }
+
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
+    }
+};
+
+#endif // CUCKOO_KV_STORE_HPP
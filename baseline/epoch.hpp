@@ -0,0 +1,186 @@
+#ifndef EPOCH_HPP
+#define EPOCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Epoch-based reclamation. Threads pin the global epoch for the duration of
+// an operation; memory unlinked by a writer is retired with the epoch it was
+// retired in and freed once the global epoch has moved two steps past it,
+// at which point no pinned thread can still hold a reference. The epoch only
+// advances when every pinned thread has observed the current one.
+//
+// One domain serves the whole process. Each thread owns a record (reused
+// after the thread exits) holding its pin state and its retired memory;
+// whatever is still waiting when a thread exits is handed to the domain and
+// freed by a later collection.
+class EpochDomain {
+private:
+    static constexpr size_t COLLECT_INTERVAL = 64; // Retires between reclamation attempts
+
+    struct Retired {
+        void* pointer;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    struct alignas(64) Record {
+        // (epoch << 1) | 1 while pinned, 0 otherwise
+        std::atomic<uint64_t> state{0};
+        std::atomic<bool> inUse{false};
+        Record* next = nullptr;
+        unsigned depth = 0; // Nested pins of the owning thread
+        std::vector<Retired> retired;
+        size_t sinceCollect = 0;
+    };
+
+    std::atomic<uint64_t> globalEpoch{1};
+    std::atomic<Record*> records{nullptr}; // Push-only list, records are never freed
+    std::mutex orphanMutex;
+    std::vector<Retired> orphans; // Left behind by exited threads
+
+    // Claim a free record, or push a new one
+    Record* acquireRecord() {
+        for (Record* r = records.load(std::memory_order_acquire); r; r = r->next) {
+            bool expected = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        Record* r = new Record();
+        r->inUse.store(true, std::memory_order_relaxed);
+        Record* head = records.load(std::memory_order_relaxed);
+        do {
+            r->next = head;
+        } while (!records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+        return r;
+    }
+
+    void releaseRecord(Record* r) {
+        collect(*r);
+        if (!r->retired.empty()) {
+            std::lock_guard<std::mutex> guard(orphanMutex);
+            orphans.insert(orphans.end(), r->retired.begin(), r->retired.end());
+            r->retired.clear();
+        }
+        r->state.store(0, std::memory_order_release);
+        r->inUse.store(false, std::memory_order_release);
+    }
+
+    // Thread-local handle releasing the record when the thread exits
+    struct ThreadHandle {
+        EpochDomain* domain = nullptr;
+        Record* record = nullptr;
+
+        ~ThreadHandle() {
+            if (record) {
+                domain->releaseRecord(record);
+            }
+        }
+    };
+
+    Record& localRecord() {
+        thread_local ThreadHandle handle;
+        if (!handle.record) {
+            handle.domain = this;
+            handle.record = acquireRecord();
+        }
+        return *handle.record;
+    }
+
+    // Advance the epoch if every pinned thread is in the current one
+    void tryAdvance() {
+        uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+        for (Record* r = records.load(std::memory_order_acquire); r; r = r->next) {
+            uint64_t state = r->state.load(std::memory_order_seq_cst);
+            if ((state & 1) && (state >> 1) != epoch) {
+                return;
+            }
+        }
+        globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    static void freeExpired(std::vector<Retired>& list, uint64_t epoch) {
+        size_t kept = 0;
+        for (const Retired& item : list) {
+            if (item.epoch + 2 <= epoch) {
+                item.deleter(item.pointer);
+            } else {
+                list[kept++] = item;
+            }
+        }
+        list.resize(kept);
+    }
+
+    void collect(Record& r) {
+        tryAdvance();
+        uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+        freeExpired(r.retired, epoch);
+
+        std::unique_lock<std::mutex> guard(orphanMutex, std::try_to_lock);
+        if (guard.owns_lock() && !orphans.empty()) {
+            freeExpired(orphans, epoch);
+        }
+    }
+
+    EpochDomain() = default;
+
+public:
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // Keep memory retired from now on alive until the matching unpin()
+    void pin() {
+        Record& r = localRecord();
+        if (r.depth++ == 0) {
+            r.state.store((globalEpoch.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_seq_cst);
+        }
+    }
+
+    void unpin() {
+        Record& r = localRecord();
+        if (--r.depth == 0) {
+            r.state.store(0, std::memory_order_release);
+        }
+    }
+
+    // Free pointer with deleter once no thread pinned now can reach it. The
+    // caller must already have unlinked it.
+    void retire(void* pointer, void (*deleter)(void*)) {
+        Record& r = localRecord();
+        r.retired.push_back({pointer, deleter, globalEpoch.load(std::memory_order_seq_cst)});
+        if (++r.sinceCollect >= COLLECT_INTERVAL) {
+            r.sinceCollect = 0;
+            collect(r);
+        }
+    }
+
+    template<typename T>
+    void retire(T* pointer) {
+        retire(pointer, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    uint64_t epoch() const { return globalEpoch.load(std::memory_order_relaxed); }
+};
+
+// Scoped pin of the process-wide epoch domain
+class EpochGuard {
+public:
+    EpochGuard() { EpochDomain::instance().pin(); }
+    ~EpochGuard() { EpochDomain::instance().unpin(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+#endif // EPOCH_HPP
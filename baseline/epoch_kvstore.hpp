@@ -0,0 +1,291 @@
+#ifndef EPOCH_KV_STORE_HPP
+#define EPOCH_KV_STORE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "epoch.hpp"
+#include "kvstore.hpp"
+#include "simd_match.hpp"
+#include "table_memory.hpp"
+
+// Thread-safe chained KV store whose reads never block and never retry.
+// Every key/value pair lives in an immutable node; a chain slot holds an
+// atomic pointer to it. Writers serialize per chain with a spinlock and never
+// modify a published node: update publishes a fresh node with an atomic swap
+// and remove clears the pointer, and the node they replaced is retired
+// through epoch-based reclamation. A reader pins the epoch, loads the slot
+// pointer and copies the value out of a node that cannot change or be freed
+// under it.
+//
+// Keys are mirrored in the chain so a lookup still compares all of them with
+// one vector instruction; the node's own key is authoritative. Growth locks
+// every chain of the live table, copies the node pointers into a table twice
+// the size, publishes it and retires the old table the same way as nodes.
+template<typename K, size_t ValueSize, typename Traits = KVStoreTraits<K, ValueSize>>
+class EpochKVStore {
+private:
+    static constexpr size_t CHAIN_SIZE = Traits::ChainSize;
+    static_assert(CHAIN_SIZE >= 1 && CHAIN_SIZE <= 32, "chain occupancy is a 32-bit mask");
+    static constexpr double DEFAULT_MAX_LOAD_FACTOR = 0.75;
+    static constexpr uint32_t FULL_MASK = CHAIN_SIZE == 32 ? ~0u : (1u << CHAIN_SIZE) - 1;
+    static constexpr unsigned SPINS_BEFORE_YIELD = 64;
+
+public:
+    using KeyType = K;
+    using ValueType = std::array<uint8_t, ValueSize>;
+
+private:
+    struct Node {
+        K key;
+        ValueType value;
+    };
+
+    struct alignas(64) Chain {
+        std::atomic<uint32_t> lock; // Writers only; 1 while held
+        uint32_t occupied;          // Slots holding a node (writer-side bookkeeping)
+        std::array<K, CHAIN_SIZE> keys;
+        std::array<std::atomic<Node*>, CHAIN_SIZE> nodes;
+
+        // Candidate slots for key; may be stale for readers, so the node is
+        // checked as well
+        uint32_t find(K key) const {
+            return matchKeyMask<K, CHAIN_SIZE>(keys.data(), key) & FULL_MASK;
+        }
+    };
+
+    struct Table {
+        ZeroedArray<Chain> chains;
+        size_t size;
+
+        explicit Table(size_t size) : chains(size), size(size) {}
+
+        Chain& chainFor(uint64_t h) { return chains[Traits::Range::index(h, size)]; }
+    };
+
+    std::atomic<Table*> current{nullptr};
+    std::mutex growthMutex;
+    std::atomic<size_t> count{0};
+    double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
+
+    static uint64_t hash(K key) {
+        return Traits::Hash::hash(static_cast<uint64_t>(key));
+    }
+
+    static void backoff(unsigned& spins) {
+        if (++spins < SPINS_BEFORE_YIELD) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            spins = 0;
+            std::this_thread::yield();
+        }
+    }
+
+    static bool tryLock(Chain& chain) {
+        uint32_t unlocked = 0;
+        return chain.lock.load(std::memory_order_relaxed) == 0 &&
+               chain.lock.compare_exchange_weak(unlocked, 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    static void unlock(Chain& chain) {
+        chain.lock.store(0, std::memory_order_release);
+    }
+
+    // Lock the chain of h in the live table. Chains of a retired table are
+    // never unlocked, so holding one means the table is still live. The
+    // caller is pinned, so a table retired meanwhile is not freed under it.
+    Chain& lockChain(uint64_t h) {
+        unsigned spins = 0;
+        for (;;) {
+            Chain& chain = current.load(std::memory_order_acquire)->chainFor(h);
+            if (tryLock(chain)) {
+                return chain;
+            }
+            backoff(spins);
+        }
+    }
+
+    // Slot holding key, or -1; only valid under the chain lock, where the
+    // mirror is exact
+    static int slotOf(const Chain& chain, K key) {
+        uint32_t hits = chain.find(key) & chain.occupied;
+        return hits ? __builtin_ctz(hits) : -1;
+    }
+
+    // Grow past the table the caller saw, unless someone already has.
+    // Caller is pinned.
+    void grow(Table* seen) {
+        std::lock_guard<std::mutex> guard(growthMutex);
+        Table* old = current.load(std::memory_order_relaxed);
+        if (old != seen) {
+            return;
+        }
+
+        for (size_t i = 0; i < old->size; ++i) {
+            unsigned spins = 0;
+            while (!tryLock(old->chains[i])) {
+                backoff(spins);
+            }
+        }
+
+        for (size_t size = Traits::Range::chainCount(old->size * 2);; size = Traits::Range::chainCount(size * 2)) {
+            auto fresh = std::make_unique<Table>(size);
+            if (rehashInto(*old, *fresh)) {
+                current.store(fresh.release(), std::memory_order_release);
+                EpochDomain::instance().retire(old);
+                return;
+            }
+        }
+    }
+
+    static bool rehashInto(Table& from, Table& to) {
+        for (size_t i = 0; i < from.size; ++i) {
+            const Chain& src = from.chains[i];
+            for (uint32_t m = src.occupied; m; m &= m - 1) {
+                size_t slot = __builtin_ctz(m);
+                Node* node = src.nodes[slot].load(std::memory_order_relaxed);
+                Chain& dst = to.chainFor(hash(node->key));
+                if ((dst.occupied & FULL_MASK) == FULL_MASK) {
+                    return false;
+                }
+                size_t free = __builtin_ctz(~dst.occupied);
+                dst.keys[free] = node->key;
+                dst.nodes[free].store(node, std::memory_order_relaxed);
+                dst.occupied |= 1u << free;
+            }
+        }
+        return true;
+    }
+
+    void store(K key, const ValueType& value) {
+        EpochGuard pinned;
+        uint64_t h = hash(key);
+        Node* node = new Node{key, value};
+        for (;;) {
+            Chain& chain = lockChain(h);
+            Table* table = current.load(std::memory_order_relaxed);
+
+            int slot = slotOf(chain, key);
+            if (slot >= 0) {
+                Node* old = chain.nodes[slot].exchange(node, std::memory_order_acq_rel);
+                unlock(chain);
+                EpochDomain::instance().retire(old);
+                return;
+            }
+
+            bool full = (chain.occupied & FULL_MASK) == FULL_MASK;
+            if (full || count.load(std::memory_order_relaxed) + 1 > maxLoadFactor * table->size * CHAIN_SIZE) {
+                unlock(chain);
+                grow(table);
+                continue;
+            }
+
+            // Readers match the mirror before loading the node, and check
+            // the node's key anyway
+            size_t free = __builtin_ctz(~chain.occupied);
+            chain.keys[free] = key;
+            chain.nodes[free].store(node, std::memory_order_release);
+            chain.occupied |= 1u << free;
+            count.fetch_add(1, std::memory_order_relaxed);
+            unlock(chain);
+            return;
+        }
+    }
+
+public:
+    // Constructor that scales the table with the expected data size (1.5x
+    // chains, like KVStore)
+    EpochKVStore(size_t dataSize = 1000000) {
+        current.store(new Table(Traits::Range::chainCount(static_cast<size_t>(dataSize * 1.5))));
+    }
+
+    // Constructor that sizes the table so expectedKeys fill at most
+    // maxLoadFactor of all chain slots; the table grows past that
+    EpochKVStore(size_t expectedKeys, double maxLoadFactor) : maxLoadFactor(maxLoadFactor) {
+        current.store(new Table(Traits::Range::chainCount(static_cast<size_t>(expectedKeys / (CHAIN_SIZE * maxLoadFactor)) + 1)));
+    }
+
+    EpochKVStore(EpochKVStore&& other) noexcept
+        : count(other.count.load()), maxLoadFactor(other.maxLoadFactor) {
+        current.store(other.current.exchange(nullptr));
+    }
+
+    EpochKVStore(const EpochKVStore&) = delete;
+    EpochKVStore& operator=(const EpochKVStore&) = delete;
+
+    // No operation may be in flight. Nodes already retired are freed by the
+    // epoch domain as usual.
+    ~EpochKVStore() {
+        Table* table = current.load();
+        if (!table) {
+            return;
+        }
+        for (auto& chain : table->chains) {
+            for (uint32_t m = chain.occupied; m; m &= m - 1) {
+                delete chain.nodes[__builtin_ctz(m)].load(std::memory_order_relaxed);
+            }
+        }
+        delete table;
+    }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // Bytes held by the live table and the live nodes
+    size_t memoryUsage() const {
+        return current.load()->chains.capacityBytes() + size() * sizeof(Node);
+    }
+
+    // Copy key's value into *out; false (and *out untouched) if absent
+    bool get(K key, ValueType* out) const {
+        EpochGuard pinned;
+        uint64_t h = hash(key);
+        const Chain& chain = current.load(std::memory_order_acquire)->chainFor(h);
+        for (uint32_t m = chain.find(key); m; m &= m - 1) {
+            const Node* node = chain.nodes[__builtin_ctz(m)].load(std::memory_order_acquire);
+            if (node && node->key == key) {
+                *out = node->value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ValueType get(K key) const {
+        ValueType result{};
+        get(key, &result);
+        return result;  // Return the found value or empty array if not found
+    }
+
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
+    }
+
+    bool remove(K key) {
+        EpochGuard pinned;
+        Chain& chain = lockChain(hash(key));
+        int slot = slotOf(chain, key);
+        if (slot < 0) {
+            unlock(chain);
+            return false;
+        }
+        Node* old = chain.nodes[slot].exchange(nullptr, std::memory_order_acq_rel);
+        chain.occupied &= ~(1u << slot);
+        count.fetch_sub(1, std::memory_order_relaxed);
+        unlock(chain);
+        EpochDomain::instance().retire(old);
+        return true;
+    }
+};
+
+#endif // EPOCH_KV_STORE_HPP
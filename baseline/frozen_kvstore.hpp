@@ -0,0 +1,360 @@
+#ifndef FROZEN_KV_STORE_HPP
+#define FROZEN_KV_STORE_HPP
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "kvstore.hpp"
+#include "table_memory.hpp"
+
+// Store for read-mostly workloads. freeze() builds a minimal perfect hash
+// (PTHash-style) over the current keys and packs the key/value records
+// densely in hash order, so a lookup of a frozen key computes its record
+// index and reads that one record: no probing, no empty slots. Updates of
+// frozen keys write the record in place; new keys go to a small delta table
+// (a KVStore) that the next freeze() merges in. Removing a frozen key leaves
+// a tombstone until then.
+//
+// The hash: keys are split into N/BUCKET_KEYS buckets, skewed so that 60% of
+// the keys share 30% of the buckets. Buckets are placed largest first, each
+// searching for a 16-bit pilot that sends all of its keys to free slots of a
+// table of N/TABLE_LOAD slots. The few keys that land past slot N are sent
+// to the table's remaining holes through a remap array, which keeps the
+// record array exactly N long. A lookup reads the bucket's pilot (half a
+// byte per key, so the pilot array stays far smaller than the records) and
+// then the record.
+template<typename K, size_t ValueSize>
+class FrozenKVStore {
+private:
+    using Value = std::array<uint8_t, ValueSize>;
+    using Delta = KVStore<K, ValueSize>;
+
+    static constexpr double BUCKET_KEYS = 4.0;   // Average keys per bucket
+    static constexpr double TABLE_LOAD = 0.99;   // Frozen keys over table slots
+    static constexpr uint32_t MAX_PILOT = UINT16_MAX;
+    static constexpr size_t MAX_SEEDS = 16;      // Builds tried before giving up
+    static constexpr size_t MIN_DELTA_KEYS = 1024;
+    static constexpr size_t DELTA_SHARE = 64;    // Delta presized for frozen / DELTA_SHARE keys
+    static constexpr double DELTA_LOAD_FACTOR = 0.75;
+
+    // Records are packed by hash index; the key confirms a hit
+    struct Record {
+        K key;
+        Value value;
+    };
+
+    TableMemoryPolicy memoryPolicy;
+    uint64_t seed = 0;
+    size_t frozenCount = 0; // N: records
+    size_t tableSlots = 0;  // N / TABLE_LOAD
+    size_t bucketCount = 0;
+    size_t denseBuckets = 0; // Buckets taking the skewed 60% of keys
+    size_t seedAttempts = 0; // Seeds tried by the last freeze()
+
+    ZeroedArray<uint16_t> pilots;
+    std::vector<uint32_t> remap; // Slot N + i goes to record remap[i]
+    ZeroedArray<Record> records;
+    std::vector<uint64_t> removed; // Tombstone bit per record
+    size_t removedCount = 0;
+
+    Delta delta;
+    std::vector<K> deltaKeys; // Keys inserted into the delta since the last freeze (may repeat)
+
+    // Uniform in [0, range) by multiply-high, without a division
+    static size_t reduce(uint64_t x, size_t range) {
+        return static_cast<size_t>((static_cast<unsigned __int128>(x) * range) >> 64);
+    }
+
+    uint64_t keyHash(K key) const {
+        return Murmur3Hash::hash(static_cast<uint64_t>(key) ^ seed);
+    }
+
+    // The low half of the hash picks the skewed part, the high half the bucket
+    size_t bucketOf(uint64_t h) const {
+        constexpr uint64_t DENSE_KEYS = static_cast<uint64_t>(0.6 * 4294967296.0);
+        uint64_t high = h >> 32;
+        if ((h & 0xffffffffULL) < DENSE_KEYS) {
+            return static_cast<size_t>((high * denseBuckets) >> 32);
+        }
+        return denseBuckets + static_cast<size_t>((high * (bucketCount - denseBuckets)) >> 32);
+    }
+
+    size_t slotOf(uint64_t h, uint32_t pilot) const {
+        return reduce(Murmur3Hash::hash(h ^ Murmur3Hash::hash(pilot + 0x9e3779b97f4a7c15ULL)), tableSlots);
+    }
+
+    size_t recordIndex(K key) const {
+        uint64_t h = keyHash(key);
+        size_t slot = slotOf(h, pilots[bucketOf(h)]);
+        return slot < frozenCount ? slot : remap[slot - frozenCount];
+    }
+
+    bool isRemoved(size_t index) const {
+        return (removed[index / 64] >> (index % 64)) & 1;
+    }
+
+    // Live frozen record of key, or nullptr
+    Record* findFrozen(K key) {
+        if (frozenCount == 0) {
+            return nullptr;
+        }
+        size_t index = recordIndex(key);
+        Record& record = records[index];
+        if (record.key != key || (removedCount && isRemoved(index))) {
+            return nullptr;
+        }
+        return &record;
+    }
+
+    const Record* findFrozen(K key) const {
+        return const_cast<FrozenKVStore*>(this)->findFrozen(key);
+    }
+
+    // Find pilots for keys hashed to hashes under the current seed; false if
+    // some bucket has no pilot
+    bool searchPilots(const std::vector<uint64_t>& hashes) {
+        size_t n = hashes.size();
+        // Keys grouped by bucket (CSR), buckets ordered largest first
+        std::vector<uint32_t> bucketStart(bucketCount + 1, 0);
+        for (uint64_t h : hashes) {
+            bucketStart[bucketOf(h) + 1]++;
+        }
+        size_t largest = 0;
+        for (size_t b = 0; b < bucketCount; ++b) {
+            largest = std::max<size_t>(largest, bucketStart[b + 1]);
+            bucketStart[b + 1] += bucketStart[b];
+        }
+        std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        std::vector<uint64_t> grouped(n);
+        for (uint64_t h : hashes) {
+            grouped[fill[bucketOf(h)]++] = h;
+        }
+        std::vector<uint32_t> bySize(largest + 2, 0);
+        for (size_t b = 0; b < bucketCount; ++b) {
+            bySize[largest - (bucketStart[b + 1] - bucketStart[b]) + 1]++;
+        }
+        for (size_t s = 1; s < bySize.size(); ++s) {
+            bySize[s] += bySize[s - 1];
+        }
+        std::vector<uint32_t> order(bucketCount);
+        for (size_t b = 0; b < bucketCount; ++b) {
+            order[bySize[largest - (bucketStart[b + 1] - bucketStart[b])]++] = static_cast<uint32_t>(b);
+        }
+
+        std::vector<uint64_t> taken((tableSlots + 63) / 64, 0);
+        std::vector<size_t> slots(largest);
+        for (uint32_t b : order) {
+            size_t first = bucketStart[b];
+            size_t size = bucketStart[b + 1] - first;
+            if (size == 0) {
+                break; // Empty buckets come last and keep pilot 0
+            }
+            uint32_t pilot = 0;
+            for (; pilot <= MAX_PILOT; ++pilot) {
+                size_t placed = 0;
+                for (; placed < size; ++placed) {
+                    size_t slot = slotOf(grouped[first + placed], pilot);
+                    if ((taken[slot / 64] >> (slot % 64)) & 1) {
+                        break;
+                    }
+                    taken[slot / 64] |= 1ULL << (slot % 64); // Also catches two keys of the bucket colliding
+                    slots[placed] = slot;
+                }
+                if (placed == size) {
+                    break;
+                }
+                for (size_t i = 0; i < placed; ++i) {
+                    taken[slots[i] / 64] &= ~(1ULL << (slots[i] % 64));
+                }
+            }
+            if (pilot > MAX_PILOT) {
+                return false;
+            }
+            pilots[b] = static_cast<uint16_t>(pilot);
+        }
+
+        // Pair each used slot past N with a hole below N
+        remap.assign(tableSlots - n, 0);
+        size_t hole = 0;
+        for (size_t slot = n; slot < tableSlots; ++slot) {
+            if ((taken[slot / 64] >> (slot % 64)) & 1) {
+                while ((taken[hole / 64] >> (hole % 64)) & 1) {
+                    hole++;
+                }
+                remap[slot - n] = static_cast<uint32_t>(hole++);
+            }
+        }
+        return true;
+    }
+
+    // Replace the frozen section with entries (distinct keys)
+    void build(const std::vector<std::pair<K, Value>>& entries) {
+        frozenCount = entries.size();
+        removed.assign((frozenCount + 63) / 64, 0);
+        removedCount = 0;
+        if (frozenCount == 0) {
+            tableSlots = bucketCount = denseBuckets = 0;
+            pilots = ZeroedArray<uint16_t>();
+            records = ZeroedArray<Record>();
+            remap.clear();
+            return;
+        }
+        tableSlots = std::max(frozenCount + 1, static_cast<size_t>(std::ceil(frozenCount / TABLE_LOAD)));
+        bucketCount = std::max<size_t>(2, static_cast<size_t>(std::ceil(frozenCount / BUCKET_KEYS)));
+        denseBuckets = std::max<size_t>(1, bucketCount * 3 / 10);
+
+        std::vector<uint64_t> hashes(frozenCount);
+        for (seedAttempts = 1;; ++seedAttempts) {
+            seed = Murmur3Hash::hash(seed + 0x632be59bd9b4e019ULL);
+            for (size_t i = 0; i < frozenCount; ++i) {
+                hashes[i] = keyHash(entries[i].first);
+            }
+            pilots = ZeroedArray<uint16_t>(bucketCount, memoryPolicy);
+            if (searchPilots(hashes)) {
+                break;
+            }
+            if (seedAttempts == MAX_SEEDS) {
+                throw std::runtime_error("FrozenKVStore: no perfect hash found");
+            }
+        }
+
+        records = ZeroedArray<Record>(frozenCount, memoryPolicy);
+        for (const auto& [key, value] : entries) {
+            records[recordIndex(key)] = {key, value};
+        }
+    }
+
+    void freshDelta(size_t expectedKeys) {
+        delta = Delta(std::max(MIN_DELTA_KEYS, expectedKeys), DELTA_LOAD_FACTOR, memoryPolicy);
+        deltaKeys.clear();
+    }
+
+    void store(K key, const Value& value) {
+        if (frozenCount != 0) {
+            size_t index = recordIndex(key);
+            Record& record = records[index];
+            if (record.key == key) {
+                if (removedCount && isRemoved(index)) {
+                    removed[index / 64] &= ~(1ULL << (index % 64));
+                    removedCount--;
+                }
+                record.value = value;
+                return;
+            }
+        }
+        size_t before = delta.size();
+        delta.update(key, value);
+        if (delta.size() != before) {
+            deltaKeys.push_back(key);
+        }
+    }
+
+public:
+    using KeyType = K;
+    using ValueType = Value;
+
+    // Constructor that sizes the delta for the dataSize keys loaded before
+    // the first freeze()
+    explicit FrozenKVStore(size_t dataSize = 1000000, const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory), delta(std::max(MIN_DELTA_KEYS, dataSize), DELTA_LOAD_FACTOR, memory) {}
+
+    size_t size() const { return frozenCount - removedCount + delta.size(); }
+
+    // Merge the delta into a new perfect hash over every live key and start
+    // an empty delta. Throws std::runtime_error if MAX_SEEDS seeds all fail,
+    // which takes duplicate 64-bit key hashes in practice.
+    void freeze() {
+        std::vector<std::pair<K, Value>> entries;
+        entries.reserve(size());
+        for (size_t i = 0; i < frozenCount; ++i) {
+            if (!isRemoved(i)) {
+                entries.emplace_back(records[i].key, records[i].value);
+            }
+        }
+        Value value;
+        for (K key : deltaKeys) {
+            // Removing as we go drops repeats of keys removed and re-inserted
+            if (delta.getInto(key, value.data())) {
+                entries.emplace_back(key, value);
+                delta.remove(key);
+            }
+        }
+        freshDelta(0);
+        build(entries);
+        freshDelta(frozenCount / DELTA_SHARE);
+    }
+
+    // Perfect hash and delta counters
+    struct FreezeStats {
+        size_t frozenKeys;   // Records, tombstones included
+        size_t tombstones;   // Frozen keys removed since the last freeze()
+        size_t deltaKeys;    // Keys in the delta table
+        double pilotBits;    // Pilot array bits per frozen key
+        size_t remapped;     // Table slots past N, each remapped into a hole
+        size_t seedAttempts; // Seeds the last freeze() tried
+    };
+
+    FreezeStats freezeStats() const {
+        double bits = frozenCount ? 8.0 * pilots.capacityBytes() / frozenCount : 0.0;
+        return {frozenCount, removedCount, delta.size(), bits, remap.size(), seedAttempts};
+    }
+
+    // Bytes held by the records, the perfect hash and the delta
+    size_t memoryUsage() const {
+        return records.capacityBytes() + pilots.capacityBytes() + remap.capacity() * sizeof(uint32_t) +
+               removed.capacity() * sizeof(uint64_t) + delta.memoryUsage() + deltaKeys.capacity() * sizeof(K);
+    }
+
+    ValueType get(K key) {
+        ValueType result{};
+        getInto(key, result.data());
+        return result;  // Empty array if not found
+    }
+
+    // Copy the value of key to dst (ValueSize bytes); false, leaving dst
+    // alone, if key is absent
+    bool getInto(K key, uint8_t* dst) {
+        if (const Record* record = findFrozen(key)) {
+            std::memcpy(dst, record->value.data(), ValueSize);
+            return true;
+        }
+        return delta.getInto(key, dst);
+    }
+
+    // Call f(const ValueType&) on the value of key where it is stored and
+    // return true, or return false without calling f if key is absent
+    template<typename F>
+    bool visit(K key, F&& f) {
+        if (const Record* record = findFrozen(key)) {
+            std::forward<F>(f)(record->value);
+            return true;
+        }
+        return delta.visit(key, std::forward<F>(f));
+    }
+
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+
+    bool remove(K key) {
+        if (findFrozen(key)) {
+            size_t index = recordIndex(key);
+            removed[index / 64] |= 1ULL << (index % 64);
+            removedCount++;
+            return true;
+        }
+        return delta.remove(key);
+    }
+
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
+    }
+};
+
+#endif // FROZEN_KV_STORE_HPP
@@ -0,0 +1,233 @@
+#ifndef HASHING_HPP
+#define HASHING_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Hash and range-reduction policies of the engines (Traits::Hash,
+// Traits::Range). KVStore, ConcurrentKVStore and EpochKVStore use both;
+// SwissKVStore and CuckooKVStore use Traits::Hash and reduce with their own
+// power-of-two masks over the low bits, so they want Murmur3Hash.
+//
+// A hash policy maps a key to 64 bits: hash(x) for one key, and hashBatch()
+// for n keys at once. With AVX2 the batch path hashes 4 keys per vector (8
+// with AVX-512DQ, which has a native 64-bit multiply) and two vectors per
+// iteration; without them, or for keys that are not 4- or 8-byte integers,
+// it is the scalar loop. Either path gives the same hashes. Like
+// simd_match.hpp, the vector paths are chosen at compile time
+// (-march=native, -mavx2 or -mavx512dq).
+//
+// A range policy maps a hash to a chain in [0, chains): chainCount() rounds
+// a requested chain count to one the policy supports, and index() reduces.
+
+// Lanes of one vector of 64-bit hashes in the compiled batch path
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+constexpr size_t HASH_BATCH_LANES = 8;
+#elif defined(__AVX2__)
+constexpr size_t HASH_BATCH_LANES = 4;
+#else
+constexpr size_t HASH_BATCH_LANES = 1;
+#endif
+
+namespace hashing_detail {
+
+// Keys the vector paths widen to 64 bits; the scalar path casts the same way
+// (sign-extending signed 4-byte keys)
+template<typename K>
+constexpr bool VECTOR_KEY = std::is_integral_v<K> && (sizeof(K) == 4 || sizeof(K) == 8);
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+template<typename K>
+inline __m512i load8(const K* keys) {
+    if constexpr (sizeof(K) == 8) {
+        return _mm512_loadu_si512(keys);
+    } else if constexpr (std::is_signed_v<K>) {
+        return _mm512_cvtepi32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys)));
+    } else {
+        return _mm512_cvtepu32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys)));
+    }
+}
+#elif defined(__AVX2__)
+template<typename K>
+inline __m256i load4(const K* keys) {
+    if constexpr (sizeof(K) == 8) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+    } else if constexpr (std::is_signed_v<K>) {
+        return _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)));
+    } else {
+        return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)));
+    }
+}
+
+// Low 64 bits of x * c per lane; AVX2 only multiplies 32-bit halves
+inline __m256i mul64(__m256i x, uint64_t c) {
+    const __m256i lo = _mm256_set1_epi64x(static_cast<long long>(c & 0xffffffffULL));
+    const __m256i hi = _mm256_set1_epi64x(static_cast<long long>(c >> 32));
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), lo), _mm256_mul_epu32(x, hi));
+    return _mm256_add_epi64(_mm256_mul_epu32(x, lo), _mm256_slli_epi64(cross, 32));
+}
+#endif
+
+// Scalar loop over keys, vector loop over whole pairs of vectors first.
+// Vec(v) hashes one vector of widened keys in place.
+template<typename Hash, typename K, typename Vec>
+inline void hashBatch(const K* keys, size_t n, uint64_t* out, [[maybe_unused]] Vec&& vec) {
+    size_t i = 0;
+    if constexpr (VECTOR_KEY<K> && HASH_BATCH_LANES > 1) {
+        constexpr size_t step = 2 * HASH_BATCH_LANES;
+        for (; i + step <= n; i += step) {
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+            __m512i a = vec(load8(keys + i));
+            __m512i b = vec(load8(keys + i + 8));
+            _mm512_storeu_si512(out + i, a);
+            _mm512_storeu_si512(out + i + 8, b);
+#elif defined(__AVX2__)
+            __m256i a = vec(load4(keys + i));
+            __m256i b = vec(load4(keys + i + 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), a);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 4), b);
+#endif
+        }
+    }
+    for (; i < n; ++i) {
+        out[i] = Hash::hash(static_cast<uint64_t>(keys[i]));
+    }
+}
+
+} // namespace hashing_detail
+
+// MurmurHash3 64-bit finalizer: every output bit depends on every input
+// bit, so any range policy may use any bits. The default.
+struct Murmur3Hash {
+    static constexpr uint32_t ID = 1; // Recorded in snapshots
+    static constexpr uint64_t C1 = 0xff51afd7ed558ccdULL;
+    static constexpr uint64_t C2 = 0xc4ceb9fe1a85ec53ULL;
+
+    static uint64_t hash(uint64_t x) {
+        x ^= x >> 33;
+        x *= C1;
+        x ^= x >> 33;
+        x *= C2;
+        x ^= x >> 33;
+        return x;
+    }
+
+    template<typename K>
+    static void hashBatch(const K* keys, size_t n, uint64_t* out) {
+        hashing_detail::hashBatch<Murmur3Hash>(keys, n, out, [](auto x) {
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+            x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+            x = _mm512_mullo_epi64(x, _mm512_set1_epi64(static_cast<long long>(C1)));
+            x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+            x = _mm512_mullo_epi64(x, _mm512_set1_epi64(static_cast<long long>(C2)));
+            x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 33));
+#elif defined(__AVX2__)
+            x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+            x = hashing_detail::mul64(x, C1);
+            x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+            x = hashing_detail::mul64(x, C2);
+            x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+#endif
+            return x;
+        });
+    }
+};
+
+// Fibonacci hashing: one multiply by 2^64 / phi. The high bits are well
+// mixed and the low bits are not, so pair it with FastRange (which uses
+// the high bits) rather than PowerOfTwoMask.
+struct FibonacciHash {
+    static constexpr uint32_t ID = 2;
+    static constexpr uint64_t MULTIPLIER = 0x9e3779b97f4a7c15ULL;
+
+    static uint64_t hash(uint64_t x) {
+        return x * MULTIPLIER;
+    }
+
+    template<typename K>
+    static void hashBatch(const K* keys, size_t n, uint64_t* out) {
+        hashing_detail::hashBatch<FibonacciHash>(keys, n, out, [](auto x) {
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+            x = _mm512_mullo_epi64(x, _mm512_set1_epi64(static_cast<long long>(MULTIPLIER)));
+#elif defined(__AVX2__)
+            x = hashing_detail::mul64(x, MULTIPLIER);
+#endif
+            return x;
+        });
+    }
+};
+
+// h % chains over a prime chain count: tolerates weak hashes, but the
+// divisor is only known at run time, so every reduction is a 64-bit
+// division. The default.
+struct PrimeModulo {
+    static constexpr uint32_t ID = 1; // Recorded in snapshots
+
+    // Smallest prime >= n (at least 2)
+    static size_t chainCount(size_t n) {
+        if (n <= 2) return 2;
+        if (!(n & 1)) n++; // Make sure it's odd
+
+        while (!isPrime(n)) {
+            n += 2;
+        }
+        return n;
+    }
+
+    static size_t index(uint64_t h, size_t chains) {
+        return h % chains;
+    }
+
+    static bool isPrime(size_t n) {
+        if (n <= 1) return false;
+        if (n <= 3) return true;
+        if (n % 2 == 0 || n % 3 == 0) return false;
+
+        for (size_t i = 5; i * i <= n; i += 6) {
+            if (n % i == 0 || n % (i + 2) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Lemire's fastrange: the high 64 bits of h * chains, one multiply for any
+// chain count. Uses the high bits of the hash.
+struct FastRange {
+    static constexpr uint32_t ID = 2;
+
+    static size_t chainCount(size_t n) {
+        return n < 1 ? 1 : n;
+    }
+
+    static size_t index(uint64_t h, size_t chains) {
+        return static_cast<size_t>((static_cast<unsigned __int128>(h) * chains) >> 64);
+    }
+};
+
+// h & (chains - 1) over a power-of-two chain count: one AND, at the price
+// of up to 2x rounding of the table. Uses the low bits of the hash.
+struct PowerOfTwoMask {
+    static constexpr uint32_t ID = 3;
+
+    static size_t chainCount(size_t n) {
+        size_t chains = 1;
+        while (chains < n) {
+            chains <<= 1;
+        }
+        return chains;
+    }
+
+    static size_t index(uint64_t h, size_t chains) {
+        return static_cast<size_t>(h) & (chains - 1);
+    }
+};
+
+#endif // HASHING_HPP
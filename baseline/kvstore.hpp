@@ -5,259 +5,1137 @@
 #include <array>
 #include <cstdint>
 #include <algorithm>
+#include <cstring>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
-// Generic KVStore template that can handle values of any size
+#include "hashing.hpp"
+#include "simd_match.hpp"
+#include "slab_allocator.hpp"
+#include "snapshot.hpp"
+#include "table_memory.hpp"
+
+// Largest value size stored inline in a chain entry by default
+constexpr size_t KVSTORE_INLINE_VALUE_MAX = 64;
+
+// Inline values need no allocator; stores hold one of these instead
+struct NoValueArena {
+    explicit NoValueArena(const TableMemoryPolicy& /*policy*/ = {}) {}
+    size_t capacityBytes() const { return 0; }
+};
+
+// Value kept directly inside the entry: no allocation on insert and no
+// pointer chase on get
+template<size_t ValueSize>
+struct InlineValueStorage {
+    using ValueType = std::array<uint8_t, ValueSize>;
+    using Arena = NoValueArena;
+    static constexpr bool isIndirect = false;
+
+    ValueType data{};
+
+    bool hasValue() const { return true; }
+    const ValueType& read() const { return data; }
+    void write(const ValueType& v, Arena&) { data = v; }
+    void release(Arena&) {}
+    const void* address() const { return &data; }
+};
+
+// Value kept out of line so large payloads do not bloat the chain. Slots
+// come from the store's slab, so inserts skip the general-purpose allocator
+// and dropping the store never visits individual values.
+template<size_t ValueSize>
+struct IndirectValueStorage {
+    using ValueType = std::array<uint8_t, ValueSize>;
+    using Arena = SlabAllocator<ValueSize, alignof(ValueType)>;
+    static constexpr bool isIndirect = true;
+
+    ValueType* data = nullptr;
+
+    bool hasValue() const { return data != nullptr; }
+    const ValueType& read() const { return *data; }
+    void write(const ValueType& v, Arena& arena) {
+        if (!data) {
+            data = new (arena.allocate()) ValueType(v);
+        } else {
+            *data = v;
+        }
+    }
+    // Hand the value's slot back before the entry is cleared
+    void release(Arena& arena) {
+        if (data) {
+            arena.deallocate(data);
+            data = nullptr;
+        }
+    }
+    const void* address() const { return data; }
+};
+
+// Probe policies (Traits::Probe). FastProbe stops at the first bucket that
+// holds the key and touches only the matching value. ObliviousProbe reads
+// every slot of the key's chain and of the stash and selects or writes the
+// value with masks instead of branches, so a hit, a miss, an update, an
+// insert and a remove touch the same cache lines and run the same
+// instructions.
+struct FastProbe {};
+struct ObliviousProbe {};
+
+// Compile-time configuration of a KVStore instantiation
+template<typename K, size_t ValueSize>
+struct KVStoreTraits {
+    // Inline for small values, heap-allocated above the threshold
+    using Storage = std::conditional_t<(ValueSize <= KVSTORE_INLINE_VALUE_MAX),
+                                       InlineValueStorage<ValueSize>,
+                                       IndirectValueStorage<ValueSize>>;
+    using Probe = FastProbe;
+    using Hash = Murmur3Hash;  // hashing.hpp
+    using Range = PrimeModulo; // hashing.hpp
+    static constexpr size_t ChainSize = 16; // Slots per chain
+    static constexpr size_t StashSize = 32; // Overflow entries for full chains
+};
+
+// Number of key/value slots that fit in one cache line next to the 32-bit
+// occupancy mask of a chain
+template<typename K, typename Storage>
+constexpr size_t slotsPerCacheLine() {
+    return (64 - sizeof(uint32_t)) / (sizeof(K) + sizeof(Storage));
+}
+
+// Dense bucket format: each chain is exactly one cache line holding as many
+// key/value pairs as fit. Values stay inline unless a value reference packs
+// more pairs into the line. Meant to be sized with the load-factor
+// constructor rather than over-provisioned.
 template<typename K, size_t ValueSize>
+struct CompactKVStoreTraits {
+    using Storage = std::conditional_t<(slotsPerCacheLine<K, InlineValueStorage<ValueSize>>() >=
+                                        slotsPerCacheLine<K, IndirectValueStorage<ValueSize>>()),
+                                       InlineValueStorage<ValueSize>,
+                                       IndirectValueStorage<ValueSize>>;
+    using Probe = FastProbe;
+    using Hash = Murmur3Hash;
+    using Range = PrimeModulo;
+    static constexpr size_t ChainSize = slotsPerCacheLine<K, Storage>();
+    static constexpr size_t StashSize = 32;
+};
+
+// Traits forcing the heap-allocated value path regardless of size
+template<typename K, size_t ValueSize>
+struct IndirectKVStoreTraits : KVStoreTraits<K, ValueSize> {
+    using Storage = IndirectValueStorage<ValueSize>;
+};
+
+// Constant-time lookups, writes and removes. Values are always inline: an
+// out-of-line value would be a data-dependent pointer chase. Every operation
+// scans the whole stash, so it is kept small.
+template<typename K, size_t ValueSize>
+struct ObliviousKVStoreTraits : KVStoreTraits<K, ValueSize> {
+    using Storage = InlineValueStorage<ValueSize>;
+    using Probe = ObliviousProbe;
+    static constexpr size_t StashSize = 8;
+};
+
+// Default traits with another hash or range-reduction policy (hashing.hpp)
+template<typename K, size_t ValueSize, typename HashPolicy, typename RangePolicy>
+struct HashedKVStoreTraits : KVStoreTraits<K, ValueSize> {
+    using Hash = HashPolicy;
+    using Range = RangePolicy;
+};
+
+// Generic KVStore template that can handle values of any size
+template<typename K, size_t ValueSize, typename Traits = KVStoreTraits<K, ValueSize>>
 class KVStore {
 private:
-    static constexpr size_t CHAIN_SIZE = 16; // Fixed chain size
-    static constexpr size_t PREFETCH_DISTANCE = 2; // Prefetch distance for chain traversal
+    static constexpr size_t CHAIN_SIZE = Traits::ChainSize; // Fixed chain size
+    static constexpr size_t STASH_SIZE = Traits::StashSize;
+    static_assert(CHAIN_SIZE >= 1 && CHAIN_SIZE <= 31, "chain occupancy shares a 32-bit word with the overflow bit");
+    static_assert(STASH_SIZE >= 1 && STASH_SIZE <= 32, "stash occupancy is a 32-bit mask");
+    static constexpr double DEFAULT_MAX_LOAD_FACTOR = 0.75; // Grow beyond this fill
+    static constexpr size_t MIGRATION_STEP = 4; // Old chains moved per operation while growing
+    static constexpr size_t PREFETCH_GROUP = 32; // Keys in flight per stage of a batched operation
+
+    using Storage = typename Traits::Storage;
+    using Hash = typename Traits::Hash;
+    using Range = typename Traits::Range;
+    
+    // Oblivious stores never grow incrementally (which chain a key is read
+    // from would depend on the migration cursor); they rebuild in one go
+    static constexpr bool OBLIVIOUS = std::is_same_v<typename Traits::Probe, ObliviousProbe>;
+    static_assert(!OBLIVIOUS || !Storage::isIndirect, "the oblivious probe needs inline values");
+    static_assert(!OBLIVIOUS || std::is_integral_v<K>, "the oblivious probe selects keys with integer masks");
     
-    struct alignas(64) Entry { // Cache line alignment (typically 64 bytes)
-        K key;
-        std::unique_ptr<std::array<uint8_t, ValueSize>> value;
-        bool isOccupied;
+    // Structure-of-arrays bucket: the keys are contiguous so one vector compare
+    // probes the whole bucket, and only the matching value slot is touched.
+    // All-zero bytes are an empty bucket, so tables come from ZeroedArray.
+    template<size_t N>
+    struct alignas(64) Bucket { // Cache line alignment
+        static constexpr uint32_t FULL_MASK = N == 32 ? ~0u : (1u << N) - 1;
         
-        Entry() : isOccupied(false), value(nullptr) {}
+        std::array<K, N> keys;
+        uint32_t occupied; // Bit i set when slot i holds a key (bits >= N are flags)
+        std::array<Storage, N> values;
         
-        Entry(K k, const std::array<uint8_t, ValueSize>& v) :
-            key(k),
-            value(std::make_unique<std::array<uint8_t, ValueSize>>(v)),
-            isOccupied(true) {}
-    };
-    
-    // Using fixed-size arrays instead of vectors for chains
-    struct alignas(64) Chain { // Cache line alignment
-        std::array<Entry, CHAIN_SIZE> entries;
-        size_t size; // Number of occupied entries in this chain
+        uint32_t slots() const { return occupied & FULL_MASK; }
+        bool full() const { return slots() == FULL_MASK; }
+        
+        // Occupied slots holding key (at most one bit set)
+        uint32_t find(K key) const {
+            return matchKeyMask<K, N>(keys.data(), key) & slots();
+        }
         
-        Chain() : size(0) {}
+        // Move key/value into the first free slot of a bucket known to have one
+        void place(K key, Storage&& value) {
+            size_t slot = __builtin_ctz(~occupied);
+            keys[slot] = key;
+            values[slot] = std::move(value);
+            occupied |= 1u << slot;
+        }
+        
+        void erase(size_t slot) {
+            values[slot] = Storage();
+            occupied &= ~(1u << slot);
+        }
     };
     
-    std::vector<Chain> table;
+    using Chain = Bucket<CHAIN_SIZE>;
+    using ChainTable = ZeroedArray<Chain>;
+    
+    // Set on a chain when one of its keys was pushed into the stash, so only
+    // lookups on such chains scan the stash. May stay set after the stash
+    // entry leaves (e.g. during a growth); it is never missing.
+    static constexpr uint32_t OVERFLOW_BIT = 1u << 31;
+    
+    TableMemoryPolicy memoryPolicy; // Page backing of the tables and value slabs
+    ChainTable table;
     size_t tableSize;
+    typename Storage::Arena valueArena{memoryPolicy}; // Out-of-line value slots
+    size_t count = 0; // Live keys
+    double maxLoadFactor = DEFAULT_MAX_LOAD_FACTOR;
     
-    // Enhanced hash function for better distribution at scale
-    size_t hash(K key) const {
-        uint64_t x = static_cast<uint64_t>(key);
-        // MurmurHash3 finalizer
-        x ^= x >> 33;
-        x *= 0xff51afd7ed558ccdULL;
-        x ^= x >> 33;
-        x *= 0xc4ceb9fe1a85ec53ULL;
-        x ^= x >> 33;
-        return x % tableSize;
-    }
-    
-    // Find the next prime number (for table sizing)
-    static size_t nextPrime(size_t n) {
-        if (n <= 2) return 2;
-        if (!(n & 1)) n++; // Make sure it's odd
-        
-        while (!isPrime(n)) {
-            n += 2;
+    // Small overflow area for keys whose chain is full; when it fills up the
+    // table grows
+    Bucket<STASH_SIZE> stash{};
+    size_t stashPeak = 0;
+    size_t stashOverflows = 0;
+    
+    // Value returned by find() under the oblivious probe
+    mutable std::array<uint8_t, ValueSize> obliviousResult{};
+    
+    // Incremental growth: while oldTable is non-empty its chains are moved into
+    // table a few at a time. Writes first evacuate the old chain of their key,
+    // so every key lives in exactly one of the two tables (or the stash).
+    ChainTable oldTable;
+    size_t oldTableSize = 0;
+    size_t migrateCursor = 0;
+    
+    static uint64_t hash(K key) {
+        return Hash::hash(static_cast<uint64_t>(key));
+    }
+    
+    static size_t chainIndex(uint64_t h, size_t chains) {
+        return Range::index(h, chains);
+    }
+    
+    bool migrating() const { return !oldTable.empty(); }
+    
+    // Push key/value into the stash for the given (full) chain
+    void stashPut(Chain& chain, K key, Storage&& value) {
+        stash.place(key, std::move(value));
+        chain.occupied |= OVERFLOW_BIT;
+        stashOverflows++;
+        stashPeak = std::max(stashPeak, static_cast<size_t>(__builtin_popcount(stash.slots())));
+    }
+    
+    // Move stash entries of table[index] back into the chain while it has
+    // room; clears its overflow bit once none are left
+    void drainStash(size_t index) {
+        Chain& chain = table[index];
+        bool remaining = false;
+        for (uint32_t m = stash.slots(); m; m &= m - 1) {
+            size_t slot = __builtin_ctz(m);
+            if (chainIndex(hash(stash.keys[slot]), tableSize) != index) {
+                continue;
+            }
+            if (chain.full()) {
+                remaining = true;
+            } else {
+                chain.place(stash.keys[slot], std::move(stash.values[slot]));
+                stash.erase(slot);
+            }
         }
-        return n;
+        if (!remaining) {
+            chain.occupied &= ~OVERFLOW_BIT;
+        }
+    }
+    
+    // Start growing into a table of at least newSize chains
+    void startGrowth(size_t newSize) {
+        oldTable = std::move(table);
+        oldTableSize = tableSize;
+        migrateCursor = 0;
+        tableSize = Range::chainCount(newSize);
+        table = ChainTable(tableSize, memoryPolicy);
+    }
+    
+    void finishGrowth() {
+        oldTable = ChainTable();
+        oldTableSize = 0;
+        migrateCursor = 0;
     }
     
-    // Simple prime checker
-    static bool isPrime(size_t n) {
-        if (n <= 1) return false;
-        if (n <= 3) return true;
-        if (n % 2 == 0 || n % 3 == 0) return false;
+    // Move every entry of old chain i, including its stashed keys, into the
+    // new table
+    void evacuate(size_t i) {
+        Chain& src = oldTable[i];
+        while (src.slots()) {
+            size_t slot = __builtin_ctz(src.slots());
+            Chain& dst = table[chainIndex(hash(src.keys[slot]), tableSize)];
+            if (!dst.full()) {
+                dst.place(src.keys[slot], std::move(src.values[slot]));
+            } else if (!stash.full()) {
+                stashPut(dst, src.keys[slot], std::move(src.values[slot]));
+            } else {
+                // The new table is already too small: finish in one go
+                rebuild(tableSize * 2);
+                return;
+            }
+            src.erase(slot);
+        }
         
-        for (size_t i = 5; i * i <= n; i += 6) {
-            if (n % i == 0 || n % (i + 2) == 0) {
-                return false;
+        if (src.occupied & OVERFLOW_BIT) {
+            // Stashed keys of this chain now belong to their new chain
+            src.occupied &= ~OVERFLOW_BIT;
+            for (uint32_t m = stash.slots(); m; m &= m - 1) {
+                size_t slot = __builtin_ctz(m);
+                uint64_t h = hash(stash.keys[slot]);
+                if (chainIndex(h, oldTableSize) != i) {
+                    continue;
+                }
+                Chain& dst = table[chainIndex(h, tableSize)];
+                if (dst.full()) {
+                    dst.occupied |= OVERFLOW_BIT;
+                } else {
+                    dst.place(stash.keys[slot], std::move(stash.values[slot]));
+                    stash.erase(slot);
+                }
             }
         }
-        return true;
     }
-
-public:
-    using ValueType = std::array<uint8_t, ValueSize>;
     
-    // Constructor that scales table size based on expected data size
-    KVStore(size_t dataSize = 1000000) {
-        // Scale the table size based on expected data size
-        // Using 1.5x the data size to reduce collisions
-        tableSize = nextPrime(static_cast<size_t>(dataSize * 1.5));
-        table.resize(tableSize);
+    // Bounded share of an in-progress growth, paid by every operation
+    void migrateStep() {
+        for (size_t n = 0; n < MIGRATION_STEP && migrating(); ++n) {
+            evacuate(migrateCursor++);
+            if (migrating() && migrateCursor == oldTableSize) {
+                finishGrowth();
+            }
+        }
     }
     
-    ValueType get(K key) {
-        size_t index = hash(key);
-        const auto& chain = table[index];
-        
-        ValueType result{};
-        bool found = false;
-        
-        // Always search the entire chain with prefetching
-        for (size_t i = 0; i < CHAIN_SIZE; ++i) {
-            // Prefetch ahead to reduce cache misses
-            if (i + PREFETCH_DISTANCE < CHAIN_SIZE) {
-                __builtin_prefetch(&chain.entries[i + PREFETCH_DISTANCE], 0, 1);
-                if (chain.entries[i + PREFETCH_DISTANCE].value) {
-                    __builtin_prefetch(chain.entries[i + PREFETCH_DISTANCE].value.get(), 0, 1);
+    // Synchronously rehash both tables and the stash into one table of at
+    // least minSize chains, doubling until every chain fits. Only used when
+    // the stash overflows in the middle of a growth.
+    void rebuild(size_t minSize) {
+        std::vector<uint64_t> hashes;
+        hashes.reserve(count);
+        for (auto* t : {&oldTable, &table}) {
+            for (const auto& chain : *t) {
+                for (uint32_t m = chain.slots(); m; m &= m - 1) {
+                    hashes.push_back(hash(chain.keys[__builtin_ctz(m)]));
                 }
             }
-            
-            const auto& entry = chain.entries[i];
-            if (entry.isOccupied && entry.key == key) {
-                if (entry.value) {
-                    result = *entry.value;
+        }
+        for (uint32_t m = stash.slots(); m; m &= m - 1) {
+            hashes.push_back(hash(stash.keys[__builtin_ctz(m)]));
+        }
+        
+        size_t chains = Range::chainCount(minSize);
+        for (;; chains = Range::chainCount(chains * 2)) {
+            std::vector<uint8_t> loads(chains, 0);
+            bool fits = true;
+            for (uint64_t h : hashes) {
+                if (++loads[chainIndex(h, chains)] > CHAIN_SIZE) {
+                    fits = false;
+                    break;
                 }
-                found = true;
-                // No break - continue searching to the end
+            }
+            if (fits) {
+                break;
             }
         }
         
-        return result;  // Return the found value or empty array if not found
+        ChainTable fresh(chains, memoryPolicy);
+        auto moveAll = [&](auto& bucket) {
+            for (uint32_t m = bucket.slots(); m; m &= m - 1) {
+                size_t slot = __builtin_ctz(m);
+                fresh[chainIndex(hash(bucket.keys[slot]), chains)].place(
+                    bucket.keys[slot], std::move(bucket.values[slot]));
+                bucket.erase(slot);
+            }
+        };
+        for (auto* t : {&oldTable, &table}) {
+            for (auto& chain : *t) {
+                moveAll(chain);
+            }
+        }
+        moveAll(stash);
+        table = std::move(fresh);
+        tableSize = chains;
+        finishGrowth();
     }
     
-    void insert(K key, const ValueType& value) {
-        size_t index = hash(key);
-        auto& chain = table[index];
-        
-        bool keyExists = false;
-        size_t existingIndex = 0;
+    // Snapshot header with the layout fields of this instantiation filled in
+    static SnapshotHeader snapshotLayout() {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.byteOrder = SNAPSHOT_BYTE_ORDER;
+        header.keyBytes = sizeof(K);
+        header.valueBytes = ValueSize;
+        header.chainSize = CHAIN_SIZE;
+        header.stashSize = STASH_SIZE;
+        header.chainBytes = sizeof(Chain);
+        header.stashBytes = sizeof(Bucket<STASH_SIZE>);
+        header.hashPolicy = Hash::ID;
+        header.rangePolicy = Range::ID;
+        header.stashOffset = (sizeof(SnapshotHeader) + alignof(Chain) - 1) / alignof(Chain) * alignof(Chain);
+        header.tableOffset = snapshotPageAlign(header.stashOffset + header.stashBytes);
+        return header;
+    }
+    
+    // Below this many keys bulkLoad inserts one at a time
+    static constexpr size_t BULK_LOAD_PARALLEL_MIN = 1 << 16;
+    
+    // Call fn(t) for t < threads, on threads - 1 new threads and the caller
+    template<typename F>
+    static void runParallel(size_t threads, F&& fn) {
+        std::vector<std::thread> helpers;
+        helpers.reserve(threads - 1);
+        for (size_t t = 1; t < threads; ++t) {
+            helpers.emplace_back([&fn, t] { fn(t); });
+        }
+        fn(0);
+        for (std::thread& helper : helpers) {
+            helper.join();
+        }
+    }
+    
+    // Parallel part of bulkLoad on a table that needs no growth. Keys are
+    // radix-partitioned by chain into one contiguous chain range per thread
+    // (stable, so each partition keeps input order), and every thread fills
+    // its own chains without synchronization. Keys whose chain is full are
+    // returned in input order for the caller to stash; they are never
+    // written to the table here, so concurrent stash lookups only read.
+    // Inline values are written in place; for out-of-line values slots[i]
+    // receives the slot of keys[i] so the values can be allocated in input
+    // order afterwards.
+    std::vector<size_t> placeInParallel(const K* keys, const std::array<uint8_t, ValueSize>* values, size_t n,
+                                        size_t threads, std::vector<Storage*>& slots) {
+        std::vector<size_t> chainOf(n);
+        std::vector<size_t> order(n);
+        std::vector<size_t> offsets(threads * threads); // [slice][partition]
+        auto partitionOf = [&](size_t chain) { return chain * threads / tableSize; };
         
-        // Check if key already exists - always scan the entire chain
-        for (size_t i = 0; i < CHAIN_SIZE; ++i) {
-            // Prefetch ahead
-            if (i + PREFETCH_DISTANCE < CHAIN_SIZE) {
-                __builtin_prefetch(&chain.entries[i + PREFETCH_DISTANCE], 0, 1);
+        // Pass 1: hash every key (in batches) and count it into its partition
+        runParallel(threads, [&](size_t t) {
+            size_t* counts = &offsets[t * threads];
+            uint64_t hashes[PREFETCH_GROUP];
+            size_t end = n * (t + 1) / threads;
+            for (size_t base = n * t / threads; base < end; base += PREFETCH_GROUP) {
+                size_t group = std::min(PREFETCH_GROUP, end - base);
+                Hash::hashBatch(keys + base, group, hashes);
+                for (size_t i = 0; i < group; ++i) {
+                    chainOf[base + i] = chainIndex(hashes[i], tableSize);
+                    counts[partitionOf(chainOf[base + i])]++;
+                }
             }
-            
-            auto& entry = chain.entries[i];
-            if (entry.isOccupied && entry.key == key) {
-                keyExists = true;
-                existingIndex = i;
-                // No break - continue searching to the end
+        });
+        
+        // Exclusive prefix sum, partition-major then slice order
+        size_t total = 0;
+        for (size_t p = 0; p < threads; ++p) {
+            for (size_t t = 0; t < threads; ++t) {
+                size_t c = offsets[t * threads + p];
+                offsets[t * threads + p] = total;
+                total += c;
             }
         }
+        std::vector<size_t> partitionEnd(threads);
+        for (size_t p = 0; p < threads; ++p) {
+            partitionEnd[p] = p + 1 < threads ? offsets[p + 1] : n;
+        }
         
-        // Update existing entry if found
-        if (keyExists) {
-            auto& entry = chain.entries[existingIndex];
-            if (!entry.value) {
-                entry.value = std::make_unique<ValueType>();
+        // Pass 2: scatter input positions into their partitions
+        runParallel(threads, [&](size_t t) {
+            size_t* next = &offsets[t * threads];
+            for (size_t i = n * t / threads; i < n * (t + 1) / threads; ++i) {
+                order[next[partitionOf(chainOf[i])]++] = i;
+            }
+        });
+        
+        // Pass 3: each thread inserts its partition in input order
+        std::vector<std::vector<size_t>> overflow(threads);
+        std::vector<size_t> added(threads, 0);
+        runParallel(threads, [&](size_t p) {
+            size_t first = p == 0 ? 0 : partitionEnd[p - 1];
+            for (size_t j = first; j < partitionEnd[p]; ++j) {
+                size_t i = order[j];
+                Chain& chain = table[chainOf[i]];
+                Storage* slot = nullptr;
+                if (uint32_t hits = chain.find(keys[i])) {
+                    slot = &chain.values[__builtin_ctz(hits)];
+                } else if (uint32_t stashHits = (chain.occupied & OVERFLOW_BIT) ? stash.find(keys[i]) : 0) {
+                    // Stash entries of this chain belong to this thread
+                    slot = &stash.values[__builtin_ctz(stashHits)];
+                } else if (!chain.full()) {
+                    chain.place(keys[i], Storage());
+                    slot = &chain.values[__builtin_ctz(chain.find(keys[i]))];
+                    added[p]++;
+                } else {
+                    chain.occupied |= OVERFLOW_BIT;
+                    overflow[p].push_back(i);
+                    continue;
+                }
+                if constexpr (Storage::isIndirect) {
+                    slots[i] = slot;
+                } else {
+                    slot->write(values[i], valueArena);
+                }
+            }
+        });
+        
+        for (size_t p = 0; p < threads; ++p) {
+            count += added[p];
+        }
+        std::vector<size_t> spilled;
+        for (const auto& list : overflow) {
+            spilled.insert(spilled.end(), list.begin(), list.end());
+        }
+        std::sort(spilled.begin(), spilled.end());
+        return spilled;
+    }
+    
+    // Value slot holding key, or nullptr. All CHAIN_SIZE keys of a chain are
+    // compared at once; the stash is only scanned for flagged chains.
+    const Storage* locate(K key, uint64_t h) const {
+        bool overflowed = false;
+        if (migrating()) {
+            // Keys of a chain that has not been moved yet are still in the old table
+            const Chain& old = oldTable[chainIndex(h, oldTableSize)];
+            if (uint32_t hits = old.find(key)) {
+                return &old.values[__builtin_ctz(hits)];
+            }
+            overflowed = old.occupied & OVERFLOW_BIT;
+        }
+        const Chain& chain = table[chainIndex(h, tableSize)];
+        if (uint32_t hits = chain.find(key)) {
+            return &chain.values[__builtin_ctz(hits)];
+        }
+        overflowed |= (chain.occupied & OVERFLOW_BIT) != 0;
+        if (overflowed) {
+            if (uint32_t hits = stash.find(key)) {
+                return &stash.values[__builtin_ctz(hits)];
+            }
+        }
+        return nullptr;
+    }
+    
+    // Opaque to the optimizer, so masks derived from x stay arithmetic
+    // instead of being turned back into branches
+    static uint32_t opaque(uint32_t x) {
+        __asm__("" : "+r"(x));
+        return x;
+    }
+    
+    // All ones if bit i of bits is set, zero otherwise
+    static uint32_t bitMask(uint32_t bits, size_t i) {
+        return 0u - ((bits >> i) & 1u);
+    }
+    
+    // Values are masked a 64-bit word at a time; byte-wise loops over
+    // std::array stay scalar because the bytes may alias
+    static constexpr size_t VALUE_WORDS = (ValueSize + 7) / 8;
+    using ValueWords = std::array<uint64_t, VALUE_WORDS>;
+    
+    static ValueWords loadWords(const std::array<uint8_t, ValueSize>& value) {
+        ValueWords words{};
+        std::memcpy(words.data(), value.data(), ValueSize);
+        return words;
+    }
+    
+    // OR the value of every slot selected in hits into out (at most one slot
+    // is selected across all buckets of a key)
+    template<size_t N>
+    static void gatherValue(const Bucket<N>& bucket, uint32_t hits, ValueWords& out) {
+        for (size_t i = 0; i < N; ++i) {
+            uint64_t m = static_cast<uint64_t>(0) - ((hits >> i) & 1u);
+            ValueWords v = loadWords(bucket.values[i].data);
+            for (size_t w = 0; w < VALUE_WORDS; ++w) {
+                out[w] |= v[w] & m;
+            }
+        }
+    }
+    
+    // Write key/value into the slots selected in bits and leave the other
+    // slots unchanged, rewriting every slot either way
+    template<size_t N>
+    static void scatterValue(Bucket<N>& bucket, uint32_t bits, K key, const std::array<uint8_t, ValueSize>& value) {
+        using Word = std::make_unsigned_t<K>;
+        ValueWords update = loadWords(value);
+        for (size_t i = 0; i < N; ++i) {
+            uint32_t m = bitMask(bits, i);
+            Word keyMask = static_cast<Word>(m);
+            bucket.keys[i] = static_cast<K>((static_cast<Word>(key) & keyMask) |
+                                            (static_cast<Word>(bucket.keys[i]) & ~keyMask));
+            uint64_t valueMask = static_cast<uint64_t>(0) - (m & 1u);
+            ValueWords v = loadWords(bucket.values[i].data);
+            for (size_t w = 0; w < VALUE_WORDS; ++w) {
+                v[w] = (update[w] & valueMask) | (v[w] & ~valueMask);
             }
-            *entry.value = value;
+            std::memcpy(bucket.values[i].data.data(), v.data(), ValueSize);
+        }
+        bucket.occupied |= bits;
+    }
+    
+    // Clear the slots selected in bits, rewriting every slot either way
+    template<size_t N>
+    static void eraseValue(Bucket<N>& bucket, uint32_t bits) {
+        for (size_t i = 0; i < N; ++i) {
+            uint64_t keep = ~(static_cast<uint64_t>(0) - ((bits >> i) & 1u));
+            ValueWords v = loadWords(bucket.values[i].data);
+            for (size_t w = 0; w < VALUE_WORDS; ++w) {
+                v[w] &= keep;
+            }
+            std::memcpy(bucket.values[i].data.data(), v.data(), ValueSize);
+        }
+        bucket.occupied &= ~bits;
+    }
+    
+    // Oblivious lookup: reads every slot of the key's chain and of the stash.
+    // (The modulo that picks the chain is assumed to take constant time.)
+    bool obliviousGet(K key, uint64_t h, std::array<uint8_t, ValueSize>& out) const {
+        const Chain& chain = table[chainIndex(h, tableSize)];
+        uint32_t chainHits = opaque(chain.find(key));
+        uint32_t stashHits = opaque(stash.find(key));
+        ValueWords selected{};
+        gatherValue(chain, chainHits, selected);
+        gatherValue(stash, stashHits, selected);
+        std::memcpy(out.data(), selected.data(), ValueSize);
+        return (chainHits | stashHits) != 0;
+    }
+    
+    // Oblivious write: an update rewrites the key's slot, an insert takes the
+    // first free chain slot (or stash slot if the chain is full), and either
+    // way every slot of the chain and of the stash is rewritten. Only running
+    // out of room shows: the table is rebuilt, as it is when the load factor
+    // is exceeded.
+    void obliviousStore(K key, const std::array<uint8_t, ValueSize>& value) {
+        if (count + 1 > maxLoadFactor * tableSize * CHAIN_SIZE) {
+            rebuild(tableSize * 2);
+        }
+        uint64_t h = hash(key);
+        for (;;) {
+            Chain& chain = table[chainIndex(h, tableSize)];
+            uint32_t chainHits = opaque(chain.find(key));
+            uint32_t stashHits = opaque(stash.find(key));
+            uint32_t absent = 0u - static_cast<uint32_t>((chainHits | stashHits) == 0);
+            uint32_t chainFree = ~chain.slots() & Chain::FULL_MASK;
+            chainFree &= 0u - chainFree; // Lowest free slot
+            uint32_t stashFree = ~stash.slots() & Bucket<STASH_SIZE>::FULL_MASK;
+            stashFree &= 0u - stashFree;
+            uint32_t chainNew = chainFree & absent;
+            uint32_t stashNew = stashFree & absent & (0u - static_cast<uint32_t>(chainFree == 0));
+            uint32_t chainWrite = opaque(chainHits | chainNew);
+            uint32_t stashWrite = opaque(stashHits | stashNew);
+            if ((chainWrite | stashWrite) == 0) {
+                // New key, full chain and full stash
+                rebuild(tableSize * 2);
+                continue;
+            }
+            scatterValue(chain, chainWrite, key, value);
+            scatterValue(stash, stashWrite, key, value);
+            uint32_t stashed = 0u - static_cast<uint32_t>(stashNew != 0);
+            chain.occupied |= OVERFLOW_BIT & stashed;
+            count += absent & 1u;
+            stashOverflows += stashed & 1u;
+            stashPeak = std::max(stashPeak, static_cast<size_t>(__builtin_popcount(stash.slots())));
             return;
         }
-        
-        // If chain is full, replace the last entry
-        if (chain.size >= CHAIN_SIZE) {
-            // Replace the last entry
-            auto& entry = chain.entries[CHAIN_SIZE - 1];
-            entry.key = key;
-            if (!entry.value) {
-                entry.value = std::make_unique<ValueType>();
-            }
-            *entry.value = value;
-            entry.isOccupied = true;
-        } else {
-            // Add to the chain
-            auto& entry = chain.entries[chain.size];
-            entry.key = key;
-            entry.value = std::make_unique<ValueType>(value);
-            entry.isOccupied = true;
-            chain.size++;
+    }
+    
+    // Oblivious remove: clears the key's slot and rewrites every slot of the
+    // chain and of the stash, hit or miss. Stashed keys stay in the stash
+    // (every lookup scans it anyway) and the overflow flag is left set.
+    bool obliviousRemove(K key) {
+        Chain& chain = table[chainIndex(hash(key), tableSize)];
+        uint32_t chainHits = opaque(chain.find(key));
+        uint32_t stashHits = opaque(stash.find(key));
+        eraseValue(chain, chainHits);
+        eraseValue(stash, stashHits);
+        uint32_t found = static_cast<uint32_t>((chainHits | stashHits) != 0);
+        count -= found;
+        return found != 0;
+    }
+    
+    // Prefetch the key and occupancy lines of the chain(s) for hash h (the
+    // whole chain under the oblivious probe)
+    void prefetchChains(uint64_t h, bool forWrite) const {
+        auto prefetch = [forWrite](const Chain& chain) {
+            if constexpr (OBLIVIOUS) {
+                const char* line = reinterpret_cast<const char*>(&chain);
+                for (size_t offset = 0; offset < sizeof(Chain); offset += 64) {
+                    if (forWrite) {
+                        __builtin_prefetch(line + offset, 1, 3);
+                    } else {
+                        __builtin_prefetch(line + offset, 0, 3);
+                    }
+                }
+            } else if (forWrite) {
+                __builtin_prefetch(&chain.keys, 1, 3);
+                __builtin_prefetch(&chain.occupied, 1, 3);
+            } else {
+                __builtin_prefetch(&chain.keys, 0, 3);
+                __builtin_prefetch(&chain.occupied, 0, 3);
+            }
+        };
+        if (migrating()) {
+            prefetch(oldTable[chainIndex(h, oldTableSize)]);
         }
+        prefetch(table[chainIndex(h, tableSize)]);
     }
     
-    bool remove(K key) {
-        size_t index = hash(key);
-        auto& chain = table[index];
+    // Write key/value: overwrite the key's slot if present, otherwise take a
+    // free slot of its chain, or a stash slot if the chain is full. The table
+    // grows when it is over the load factor or the stash is full.
+    void store(K key, const std::array<uint8_t, ValueSize>& value) {
+        if constexpr (OBLIVIOUS) {
+            obliviousStore(key, value);
+            return;
+        }
+        migrateStep();
+        uint64_t h = hash(key);
+        if (migrating()) {
+            evacuate(chainIndex(h, oldTableSize));
+        }
         
-        bool found = false;
-        size_t foundIndex = 0;
+        Chain& chain = table[chainIndex(h, tableSize)];
+        uint32_t hits = chain.find(key);
+        if (hits) {
+            chain.values[__builtin_ctz(hits)].write(value, valueArena);
+            return;
+        }
+        if (chain.occupied & OVERFLOW_BIT) {
+            hits = stash.find(key);
+            if (hits) {
+                stash.values[__builtin_ctz(hits)].write(value, valueArena);
+                return;
+            }
+        }
         
-        // Always scan the entire chain with prefetching
-        for (size_t i = 0; i < CHAIN_SIZE; ++i) {
-            // Prefetch ahead
-            if (i + PREFETCH_DISTANCE < CHAIN_SIZE) {
-                __builtin_prefetch(&chain.entries[i + PREFETCH_DISTANCE], 0, 1);
+        if (!migrating() && count + 1 > maxLoadFactor * tableSize * CHAIN_SIZE) {
+            startGrowth(tableSize * 2);
+        }
+        for (;;) {
+            Chain& target = table[chainIndex(h, tableSize)];
+            if (!target.full() || !stash.full()) {
+                Storage slot;
+                slot.write(value, valueArena);
+                if (!target.full()) {
+                    target.place(key, std::move(slot));
+                } else {
+                    stashPut(target, key, std::move(slot));
+                }
+                count++;
+                return;
             }
-            
-            if (chain.entries[i].isOccupied && chain.entries[i].key == key) {
-                found = true;
-                foundIndex = i;
-                // No break - continue searching to the end
+            if (migrating()) {
+                rebuild(tableSize * 2);
+            } else {
+                startGrowth(tableSize * 2);
+            }
+        }
+    }
+    
+public:
+    using KeyType = K;
+    using ValueType = std::array<uint8_t, ValueSize>;
+    
+    // Constructor that scales table size based on expected data size
+    KVStore(size_t dataSize = 1000000, const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory), valueArena(memory) {
+        // Scale the table size based on expected data size
+        // Using 1.5x the data size to reduce collisions
+        tableSize = Range::chainCount(static_cast<size_t>(dataSize * 1.5));
+        table = ChainTable(tableSize, memoryPolicy);
+    }
+    
+    // Constructor that sizes the table so expectedKeys fill at most
+    // maxLoadFactor of all chain slots; the table grows past that
+    KVStore(size_t expectedKeys, double maxLoadFactor, const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory), valueArena(memory), maxLoadFactor(maxLoadFactor) {
+        size_t chains = static_cast<size_t>(expectedKeys / (CHAIN_SIZE * maxLoadFactor)) + 1;
+        tableSize = Range::chainCount(chains);
+        table = ChainTable(tableSize, memoryPolicy);
+    }
+    
+    size_t size() const { return count; }
+    
+    // True while an incremental growth is in progress
+    bool resizing() const { return migrating(); }
+    
+    // Stash occupancy counters
+    struct StashStats {
+        size_t size;      // Keys currently in the stash
+        size_t capacity;  // Stash slots
+        size_t peak;      // Highest occupancy seen
+        size_t overflows; // Keys ever pushed into the stash by a full chain
+    };
+    
+    StashStats stashStats() const {
+        return {static_cast<size_t>(__builtin_popcount(stash.slots())), STASH_SIZE, stashPeak, stashOverflows};
+    }
+    
+    // Bytes held by the chain tables plus the slabs of out-of-line values
+    size_t memoryUsage() const {
+        return table.capacityBytes() + oldTable.capacityBytes() + sizeof(stash) + valueArena.capacityBytes();
+    }
+    
+    // Page backing the live table actually got (requested backing may be
+    // unavailable, and tables under 1 MB always use the heap)
+    HugePages tablePageBacking() const { return table.pageBacking(); }
+    
+    ValueType get(K key) {
+        if constexpr (OBLIVIOUS) {
+            ValueType result;
+            obliviousGet(key, hash(key), result);
+            return result;
+        }
+        migrateStep();
+        const Storage* value = locate(key, hash(key));
+        if (value && value->hasValue()) {
+            return value->read();
+        }
+        return ValueType{};  // Empty array if not found
+    }
+    
+    // Copy the value of key to dst (ValueSize bytes) and return true, or
+    // return false and leave dst alone if key is absent. Unlike get() there
+    // is no temporary: the value is copied once, straight from its slot.
+    // Under the oblivious probe dst is written either way (zeros on a miss).
+    bool getInto(K key, uint8_t* dst) {
+        if constexpr (OBLIVIOUS) {
+            bool found = obliviousGet(key, hash(key), obliviousResult);
+            std::memcpy(dst, obliviousResult.data(), ValueSize);
+            return found;
+        }
+        migrateStep();
+        const Storage* value = locate(key, hash(key));
+        if (!value || !value->hasValue()) {
+            return false;
+        }
+        std::memcpy(dst, value->read().data(), ValueSize);
+        return true;
+    }
+    
+    // Call f(const ValueType&) on the value of key where it is stored and
+    // return true, or return false without calling f if key is absent. The
+    // reference must not outlive the call, and f must not modify the store.
+    // Under the oblivious probe f sees a copy selected by obliviousGet.
+    template<typename F>
+    bool visit(K key, F&& f) {
+        if constexpr (OBLIVIOUS) {
+            if (!obliviousGet(key, hash(key), obliviousResult)) {
+                return false;
             }
+            std::forward<F>(f)(static_cast<const ValueType&>(obliviousResult));
+            return true;
         }
+        migrateStep();
+        const Storage* value = locate(key, hash(key));
+        if (!value || !value->hasValue()) {
+            return false;
+        }
+        std::forward<F>(f)(value->read());
+        return true;
+    }
+    
+    // Batched get: out[i] receives the value of keys[i] (all-zero if absent).
+    // Each group of keys is hashed and all of its chains prefetched first,
+    // then the chains are probed and the matching value slots prefetched, and
+    // only then are the values copied out, so the misses of a group overlap
+    // instead of serializing.
+    void multiGet(const K* keys, size_t n, ValueType* out) {
+        uint64_t hashes[PREFETCH_GROUP];
+        const Storage* found[PREFETCH_GROUP];
         
-        if (found) {
-            // Mark as not occupied
-            chain.entries[foundIndex].isOccupied = false;
+        for (size_t base = 0; base < n; base += PREFETCH_GROUP) {
+            size_t group = std::min(PREFETCH_GROUP, n - base);
+            for (size_t i = 0; i < group; ++i) {
+                migrateStep();
+            }
             
-            // Shift entries to keep them contiguous
-            if (foundIndex < chain.size - 1) {
-                // Move the last entry to this position
-                chain.entries[foundIndex] = std::move(chain.entries[chain.size - 1]);
-                // Clear the last entry
-                chain.entries[chain.size - 1] = Entry();
+            // Stage 1: hash the group as one batch and prefetch the chains
+            Hash::hashBatch(keys + base, group, hashes);
+            for (size_t i = 0; i < group; ++i) {
+                prefetchChains(hashes[i], false);
+            }
+            if constexpr (OBLIVIOUS) {
+                // Values were prefetched with their chains
+                for (size_t i = 0; i < group; ++i) {
+                    obliviousGet(keys[base + i], hashes[i], out[base + i]);
+                }
+                continue;
+            }
+            // Stage 2: probe and prefetch the value slots
+            for (size_t i = 0; i < group; ++i) {
+                found[i] = locate(keys[base + i], hashes[i]);
+                if (found[i] && found[i]->hasValue()) {
+                    __builtin_prefetch(found[i]->address(), 0, 3);
+                }
             }
+            // Stage 3: copy the values out
+            for (size_t i = 0; i < group; ++i) {
+                if (found[i] && found[i]->hasValue()) {
+                    out[base + i] = found[i]->read();
+                } else {
+                    out[base + i] = ValueType{};
+                }
+            }
+        }
+    }
+    
+    // Batched update (insert if absent) of keys[i] to values[i], in order.
+    // Chains and existing value slots are prefetched for the whole group
+    // before any of them is written.
+    void multiUpdate(const K* keys, size_t n, const ValueType* values) {
+        uint64_t hashes[PREFETCH_GROUP];
+        
+        for (size_t base = 0; base < n; base += PREFETCH_GROUP) {
+            size_t group = std::min(PREFETCH_GROUP, n - base);
             
-            chain.size--;
-            return true;
+            Hash::hashBatch(keys + base, group, hashes);
+            for (size_t i = 0; i < group; ++i) {
+                prefetchChains(hashes[i], true);
+            }
+            for (size_t i = 0; !OBLIVIOUS && i < group; ++i) {
+                const Storage* value = locate(keys[base + i], hashes[i]);
+                if (value && value->hasValue()) {
+                    __builtin_prefetch(value->address(), 1, 3);
+                }
+            }
+            // store() probes again, now from cache, and handles growth
+            for (size_t i = 0; i < group; ++i) {
+                store(keys[base + i], values[base + i]);
+            }
+        }
+    }
+    
+    // Snapshots store the chains and the stash as raw bytes, which holds
+    // no pointers only when values are inline
+    static constexpr bool SUPPORTS_SNAPSHOTS = !Storage::isIndirect;
+    
+    // Write the store to path in one sequential pass: header page, stash,
+    // then the chain table from a page boundary. A growth in progress is
+    // finished first so there is a single table to write.
+    void saveSnapshot(const std::string& path) {
+        static_assert(SUPPORTS_SNAPSHOTS, "snapshots need inline values");
+        if (migrating()) {
+            rebuild(tableSize);
         }
+        SnapshotHeader header = snapshotLayout();
+        header.tableSize = tableSize;
+        header.count = count;
+        header.maxLoadFactor = maxLoadFactor;
+        header.stashPeak = stashPeak;
+        header.stashOverflows = stashOverflows;
+        header.tableBytes = tableSize * sizeof(Chain);
         
-        return false;
+        SnapshotWriter out(path);
+        out.write(&header, sizeof(header));
+        out.pad(header.stashOffset);
+        out.write(&stash, sizeof(stash));
+        out.pad(SNAPSHOT_PAGE_BYTES);
+        out.write(table.begin(), header.tableBytes);
+        out.commit();
     }
     
-    void update(K key, const ValueType& newValue) {
-        size_t index = hash(key);
-        auto& chain = table[index];
+    // Open a snapshot written by saveSnapshot of the same instantiation. The
+    // chain table is mapped from the file rather than read, so opening takes
+    // the same few system calls at any size and pages come in on first use.
+    // A ReadOnly store must only be read (get, getInto, visit, multiGet,
+    // find); a CopyOnWrite store supports every operation, and its writes
+    // stay private to the process. Throws std::runtime_error if the file is
+    // missing, truncated or has a different layout.
+    static KVStore openSnapshot(const std::string& path, SnapshotMode mode = SnapshotMode::CopyOnWrite) {
+        static_assert(SUPPORTS_SNAPSHOTS, "snapshots need inline values");
+        SnapshotReader in(path);
+        const SnapshotHeader& header = in.info();
+        SnapshotHeader expected = snapshotLayout();
+        if (header.keyBytes != expected.keyBytes || header.valueBytes != expected.valueBytes ||
+            header.chainSize != expected.chainSize || header.stashSize != expected.stashSize ||
+            header.chainBytes != expected.chainBytes || header.stashBytes != expected.stashBytes ||
+            header.hashPolicy != expected.hashPolicy || header.rangePolicy != expected.rangePolicy ||
+            header.stashOffset != expected.stashOffset || header.tableSize == 0 ||
+            header.tableBytes != header.tableSize * sizeof(Chain)) {
+            throw std::runtime_error("snapshot layout does not match this store: " + path);
+        }
         
-        bool keyExists = false;
-        size_t existingIndex = 0;
+        KVStore store(0);
+        in.read(header.stashOffset, &store.stash, sizeof(store.stash));
+        store.table = ChainTable::adoptMapping(in.map(header.tableOffset, header.tableBytes, mode),
+                                               header.tableSize, header.tableBytes);
+        store.tableSize = header.tableSize;
+        store.count = header.count;
+        store.maxLoadFactor = header.maxLoadFactor;
+        store.stashPeak = header.stashPeak;
+        store.stashOverflows = header.stashOverflows;
+        return store;
+    }
+    
+    // Insert (or update) keys[i] -> values[i] for all i < n, using up to
+    // threads cores (0: all). The table first grows to hold n more keys, then
+    // the keys are placed in parallel, each thread owning a contiguous range
+    // of chains, and out-of-line values are allocated from the slab in input
+    // order. When the table needs no growth the result, down to which slot
+    // and stash entry every key occupies, is the same as calling insert() in
+    // input order; small inputs and the oblivious probe do exactly that.
+    void bulkLoad(const K* keys, const ValueType* values, size_t n, size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, std::max<size_t>(1, n / BULK_LOAD_PARALLEL_MIN));
+        if (OBLIVIOUS || threads == 1) {
+            for (size_t i = 0; i < n; ++i) {
+                store(keys[i], values[i]);
+            }
+            return;
+        }
         
-        // Always scan the entire chain with prefetching
-        for (size_t i = 0; i < CHAIN_SIZE; ++i) {
-            // Prefetch ahead
-            if (i + PREFETCH_DISTANCE < CHAIN_SIZE) {
-                __builtin_prefetch(&chain.entries[i + PREFETCH_DISTANCE], 0, 1);
+        // Grow once up front instead of partway through (duplicates make
+        // count + n an upper bound); a pending migration is finished too
+        if (count + n > maxLoadFactor * tableSize * CHAIN_SIZE) {
+            rebuild(static_cast<size_t>((count + n) / (CHAIN_SIZE * maxLoadFactor)) + 1);
+        } else if (migrating()) {
+            rebuild(tableSize);
+        }
+        
+        std::vector<Storage*> slots(Storage::isIndirect ? n : 0);
+        std::vector<size_t> spilled = placeInParallel(keys, values, n, threads, slots);
+        
+        // Keys of full chains go to the stash in input order, as they would
+        // one at a time; whatever does not fit waits until the slots above
+        // have their values, since growing moves entries
+        std::vector<size_t> deferred;
+        for (size_t i : spilled) {
+            Chain& chain = table[chainIndex(hash(keys[i]), tableSize)];
+            Storage* slot = nullptr;
+            if (uint32_t hits = stash.find(keys[i])) {
+                slot = &stash.values[__builtin_ctz(hits)];
+            } else if (!stash.full() && deferred.empty()) {
+                stashPut(chain, keys[i], Storage());
+                slot = &stash.values[__builtin_ctz(stash.find(keys[i]))];
+                count++;
+            } else {
+                deferred.push_back(i);
+                continue;
             }
-            
-            auto& entry = chain.entries[i];
-            if (entry.isOccupied && entry.key == key) {
-                keyExists = true;
-                existingIndex = i;
-                // No break - continue searching to the end
+            if constexpr (Storage::isIndirect) {
+                slots[i] = slot;
+            } else {
+                slot->write(values[i], valueArena);
             }
         }
         
-        // Update existing entry if found
-        if (keyExists) {
-            auto& entry = chain.entries[existingIndex];
-            if (!entry.value) {
-                entry.value = std::make_unique<ValueType>();
+        if constexpr (Storage::isIndirect) {
+            for (size_t i = 0; i < n; ++i) {
+                if (slots[i]) {
+                    slots[i]->write(values[i], valueArena);
+                }
             }
-            *entry.value = newValue;
+        }
+        for (size_t i : deferred) {
+            store(keys[i], values[i]);
+        }
+    }
+    
+    // Split-phase access for interleaved executors. prefetchKey() pays the
+    // operation's share of any growth, hashes key and prefetches its
+    // chain(s); prefetchValue() probes them and prefetches the value slot;
+    // find() returns the value or nullptr. Pointers from find() are only
+    // valid until the next operation on the store, so callers copy out in
+    // the same step. Under the oblivious probe prefetchKey() fetches whole
+    // chains, prefetchValue() does nothing and find() copies into a buffer.
+    uint64_t prefetchKey(K key, bool forWrite = false) {
+        migrateStep();
+        uint64_t h = hash(key);
+        prefetchChains(h, forWrite);
+        return h;
+    }
+    
+    void prefetchValue(K key, uint64_t h, bool forWrite = false) const {
+        if constexpr (OBLIVIOUS) {
+            return;
+        }
+        const Storage* value = locate(key, h);
+        if (!value) {
             return;
         }
+        if (forWrite) {
+            __builtin_prefetch(value, 1, 3);
+        } else if (value->hasValue()) {
+            __builtin_prefetch(value->address(), 0, 3);
+        }
+    }
+    
+    const ValueType* find(K key, uint64_t h) const {
+        if constexpr (OBLIVIOUS) {
+            return obliviousGet(key, h, obliviousResult) ? &obliviousResult : nullptr;
+        }
+        const Storage* value = locate(key, h);
+        return value && value->hasValue() ? &value->read() : nullptr;
+    }
+    
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+    
+    bool remove(K key) {
+        if constexpr (OBLIVIOUS) {
+            return obliviousRemove(key);
+        }
+        migrateStep();
+        uint64_t h = hash(key);
+        if (migrating()) {
+            evacuate(chainIndex(h, oldTableSize));
+        }
+        size_t index = chainIndex(h, tableSize);
+        auto& chain = table[index];
         
-        // Key not found, handle similar to insert
-        if (chain.size >= CHAIN_SIZE) {
-            // Replace the last entry
-            auto& entry = chain.entries[CHAIN_SIZE - 1];
-            entry.key = key;
-            if (!entry.value) {
-                entry.value = std::make_unique<ValueType>();
-            }
-            *entry.value = newValue;
-            entry.isOccupied = true;
+        // Free the slot; the occupancy mask makes compaction unnecessary
+        if (uint32_t hits = chain.find(key)) {
+            chain.values[__builtin_ctz(hits)].release(valueArena);
+            chain.erase(__builtin_ctz(hits));
+        } else if (uint32_t stashHits = (chain.occupied & OVERFLOW_BIT) ? stash.find(key) : 0) {
+            stash.values[__builtin_ctz(stashHits)].release(valueArena);
+            stash.erase(__builtin_ctz(stashHits));
         } else {
-            // Add to the chain
-            auto& entry = chain.entries[chain.size];
-            entry.key = key;
-            entry.value = std::make_unique<ValueType>(newValue);
-            entry.isOccupied = true;
-            chain.size++;
+            return false;
+        }
+        count--;
+        
+        // Pull stashed keys of this chain back into the freed room
+        if ((chain.occupied & OVERFLOW_BIT) && !migrating()) {
+            drainStash(index);
         }
+        return true;
+    }
+    
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
     }
 };
 
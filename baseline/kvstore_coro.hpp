@@ -0,0 +1,185 @@
+#ifndef KV_STORE_CORO_HPP
+#define KV_STORE_CORO_HPP
+
+// Coroutine-interleaved execution of KVStore operations (requires C++20).
+// Every get/update runs as a coroutine that suspends right after issuing a
+// prefetch; a round-robin scheduler keeps up to `degree` operations in
+// flight, so while one waits for DRAM the others make progress.
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Recycles coroutine frames so starting an operation does not hit the
+// general-purpose allocator. Frames are kept per size on a thread-local
+// free list.
+class CoroFramePool {
+private:
+    struct FreeList {
+        size_t size;
+        std::vector<void*> frames;
+    };
+    
+    static std::vector<FreeList>& lists() {
+        thread_local struct Lists {
+            std::vector<FreeList> all;
+            ~Lists() {
+                for (auto& list : all) {
+                    for (void* frame : list.frames) {
+                        ::operator delete(frame);
+                    }
+                }
+            }
+        } pools;
+        return pools.all;
+    }
+    
+    static FreeList& listFor(size_t size) {
+        // Executors create frames of one or two sizes in a tight loop
+        thread_local size_t lastIndex = 0;
+        auto& all = lists();
+        if (lastIndex < all.size() && all[lastIndex].size == size) {
+            return all[lastIndex];
+        }
+        for (lastIndex = 0; lastIndex < all.size(); ++lastIndex) {
+            if (all[lastIndex].size == size) {
+                return all[lastIndex];
+            }
+        }
+        all.push_back({size, {}});
+        return all.back();
+    }
+    
+public:
+    static void* allocate(size_t size) {
+        auto& list = listFor(size);
+        if (list.frames.empty()) {
+            return ::operator new(size);
+        }
+        void* frame = list.frames.back();
+        list.frames.pop_back();
+        return frame;
+    }
+    
+    static void release(void* frame, size_t size) {
+        listFor(size).frames.push_back(frame);
+    }
+};
+
+// Eagerly started operation: runs up to its first suspension point when
+// created and is then resumed by the scheduler
+struct InterleavedTask {
+    struct promise_type {
+        InterleavedTask get_return_object() {
+            return {std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+        
+        static void* operator new(size_t size) { return CoroFramePool::allocate(size); }
+        static void operator delete(void* frame, size_t size) { CoroFramePool::release(frame, size); }
+    };
+    
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Round-robin scheduler over a store's split-phase API (prefetchKey,
+// prefetchValue, find, update). Operations wait in a FIFO ring of `degree`
+// slots; submitting when the ring is full advances the oldest ones until a
+// slot frees up, and drain() completes everything outstanding. Every
+// operation suspends exactly twice and the oldest is always resumed first,
+// so operations take effect in submission order.
+template<typename Store>
+class InterleavedExecutor {
+public:
+    using KeyType = typename Store::KeyType;
+    using ValueType = typename Store::ValueType;
+    
+    InterleavedExecutor(Store& store, size_t degree)
+        : store(store), ring(degree == 0 ? 1 : degree) {}
+    
+    InterleavedExecutor(const InterleavedExecutor&) = delete;
+    InterleavedExecutor& operator=(const InterleavedExecutor&) = delete;
+    
+    ~InterleavedExecutor() {
+        drain();
+    }
+    
+    size_t degree() const { return ring.size(); }
+    
+    // Look key up; *out receives its value (all-zero if absent) by the time
+    // drain() returns
+    void get(KeyType key, ValueType* out) {
+        while (active == ring.size()) {
+            step();
+        }
+        push(getTask(store, key, out));
+    }
+    
+    // Update (or insert) key; applied by the time drain() returns
+    void update(KeyType key, const ValueType& value) {
+        while (active == ring.size()) {
+            step();
+        }
+        push(updateTask(store, key, value));
+    }
+    
+    // Run every in-flight operation to completion
+    void drain() {
+        while (active > 0) {
+            step();
+        }
+    }
+    
+private:
+    Store& store;
+    std::vector<std::coroutine_handle<>> ring;
+    size_t head = 0;
+    size_t active = 0;
+    
+    static InterleavedTask getTask(Store& store, KeyType key, ValueType* out) {
+        uint64_t h = store.prefetchKey(key);
+        co_await std::suspend_always{};
+        store.prefetchValue(key, h);
+        co_await std::suspend_always{};
+        // Probe again: other operations may have moved the entry meanwhile
+        const ValueType* value = store.find(key, h);
+        *out = value ? *value : ValueType{};
+    }
+    
+    static InterleavedTask updateTask(Store& store, KeyType key, ValueType value) {
+        uint64_t h = store.prefetchKey(key, true);
+        co_await std::suspend_always{};
+        store.prefetchValue(key, h, true);
+        co_await std::suspend_always{};
+        store.update(key, value);
+    }
+    
+    // Caller guarantees a free slot (tasks run up to their first suspension
+    // when created, so this happens before the task is constructed)
+    void push(InterleavedTask task) {
+        ring[(head + active) % ring.size()] = task.handle;
+        active++;
+    }
+    
+    // Resume the oldest in-flight operation and requeue it unless it finished
+    void step() {
+        std::coroutine_handle<> task = ring[head];
+        head = (head + 1) % ring.size();
+        active--;
+        task.resume();
+        if (task.done()) {
+            task.destroy();
+        } else {
+            ring[(head + active) % ring.size()] = task;
+            active++;
+        }
+    }
+};
+
+#endif // KV_STORE_CORO_HPP
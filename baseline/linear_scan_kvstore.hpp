@@ -0,0 +1,609 @@
+#ifndef LINEAR_SCAN_KV_STORE_HPP
+#define LINEAR_SCAN_KV_STORE_HPP
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "simd_match.hpp"
+#include "table_memory.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINEAR_SCAN_X86_DISPATCH 1
+#endif
+
+// Instruction sets the scan kernels are built for; the best one the CPU
+// supports is picked at run time
+enum class ScanIsa {
+    Baseline, // Whatever the build targets (SSE2 on x86-64 by default)
+    Avx2,
+    Avx512
+};
+
+inline ScanIsa detectScanIsa() {
+#ifdef LINEAR_SCAN_X86_DISPATCH
+    if (__builtin_cpu_supports("avx512f")) {
+        return ScanIsa::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return ScanIsa::Avx2;
+    }
+#endif
+    return ScanIsa::Baseline;
+}
+
+inline const char* scanIsaName(ScanIsa isa) {
+    switch (isa) {
+    case ScanIsa::Avx512: return "avx512";
+    case ScanIsa::Avx2: return "avx2";
+    default:
+#if defined(__AVX2__)
+        return "avx2 (build)";
+#elif defined(__SSE2__)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+}
+
+// Fixed set of helper threads that run one task on a range of participant
+// ids and wait for all of them; the calling thread is participant 0
+class ScanWorkerPool {
+private:
+    std::vector<std::thread> helpers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(size_t)>* task = nullptr;
+    size_t active = 0;    // Participants of the current run
+    size_t remaining = 0; // Helpers of the current run still working
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void helperLoop(size_t id) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            if (id >= active) {
+                continue;
+            }
+            const std::function<void(size_t)>& fn = *task;
+            lock.unlock();
+            fn(id);
+            lock.lock();
+            if (--remaining == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ScanWorkerPool(size_t participants) {
+        for (size_t id = 1; id < participants; ++id) {
+            helpers.emplace_back([this, id] { helperLoop(id); });
+        }
+    }
+
+    ScanWorkerPool(const ScanWorkerPool&) = delete;
+    ScanWorkerPool& operator=(const ScanWorkerPool&) = delete;
+
+    ~ScanWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& helper : helpers) {
+            helper.join();
+        }
+    }
+
+    // Participants available, including the caller
+    size_t size() const { return helpers.size() + 1; }
+
+    // Call fn(id) for every id < participants (capped at size()) and return
+    // once all calls have finished
+    void run(size_t participants, const std::function<void(size_t)>& fn) {
+        participants = std::min(participants, size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &fn;
+            active = participants;
+            remaining = participants - 1;
+            ++generation;
+        }
+        wake.notify_all();
+        fn(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return remaining == 0; });
+    }
+};
+
+// Oblivious map that reads (and for writes, rewrites) every slot of the
+// table on every access: the trivial ORAM used as the CPU comparator for
+// oblivious stores. Keys and values sit in flat slot arrays; each access
+// compares the whole key array with SIMD and selects or writes values with
+// masks, so its memory trace and instruction stream depend only on the
+// number of slots in use. Up to MAX_SCAN_BATCH queries share one pass over
+// the table, and large tables are split across a pool of scan threads.
+//
+// Slots are handed out in insertion order and never reused: remove() only
+// clears the slot's live bit, since reusing it would show which slot was
+// freed. Memory therefore follows the number of keys ever inserted, and
+// size() shows whether a write inserted, as in any map with a public size.
+template<typename K, size_t ValueSize>
+class LinearScanKVStore {
+public:
+    using KeyType = K;
+    using ValueType = std::array<uint8_t, ValueSize>;
+
+private:
+    static_assert(std::is_integral_v<K> && (sizeof(K) == 4 || sizeof(K) == 8),
+                  "linear scan compares 4- or 8-byte integer keys");
+
+    static constexpr size_t BLOCK = 32;                // Slots per match mask
+    static constexpr size_t VALUE_WORDS = (ValueSize + 7) / 8;
+    static constexpr size_t BLOCK_WORDS = BLOCK * VALUE_WORDS;
+    static constexpr size_t MAX_SCAN_BATCH = 32;       // Queries per pass
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 1024; // Smaller tables scan on one thread
+    static constexpr size_t NO_SLOT = ~static_cast<size_t>(0);
+
+    using ValueWords = std::array<uint64_t, VALUE_WORDS>;
+    using Match = uint32_t (*)(const K*, K);
+
+    // Per-participant scratch of a read pass
+    struct ScanPartial {
+        std::array<uint64_t, MAX_SCAN_BATCH * BLOCK_WORDS> selected; // Per query, one block wide
+        std::array<uint32_t, MAX_SCAN_BATCH> hits;
+    };
+
+    TableMemoryPolicy memoryPolicy;
+    ZeroedArray<K> keys;
+    ZeroedArray<uint32_t> liveBits; // Bit s of word b: slot b * BLOCK + s holds a key
+    ZeroedArray<uint64_t> values;   // VALUE_WORDS words per slot
+    size_t capacity = 0;            // Slots, a multiple of BLOCK
+    size_t used = 0;                // Slots handed out so far
+    size_t count = 0;
+    size_t passes = 0;
+
+    ScanIsa isa = ScanIsa::Baseline;
+    std::unique_ptr<ScanWorkerPool> workers;
+    std::vector<ScanPartial> partials;
+
+    // Opaque to the optimizer, so masks derived from x stay arithmetic
+    static uint32_t opaque(uint32_t x) {
+        __asm__("" : "+r"(x));
+        return x;
+    }
+
+    static ValueWords loadWords(const ValueType& value) {
+        ValueWords words{};
+        std::memcpy(words.data(), value.data(), ValueSize);
+        return words;
+    }
+
+    // Key comparison over one block of slots, one variant per ISA
+
+    static uint32_t matchBaseline(const K* block, K key) {
+        return matchKeyMask<K, BLOCK>(block, key);
+    }
+
+#ifdef LINEAR_SCAN_X86_DISPATCH
+    __attribute__((target("avx2")))
+    static uint32_t matchAvx2(const K* block, K key) {
+        uint32_t mask = 0;
+        if constexpr (sizeof(K) == 4) {
+            const __m256i needle = _mm256_set1_epi32(static_cast<int32_t>(key));
+            for (size_t i = 0; i < BLOCK; i += 8) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+                __m256i eq = _mm256_cmpeq_epi32(v, needle);
+                mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(eq))) << i;
+            }
+        } else {
+            const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(key));
+            for (size_t i = 0; i < BLOCK; i += 4) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+                __m256i eq = _mm256_cmpeq_epi64(v, needle);
+                mask |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(eq))) << i;
+            }
+        }
+        return mask;
+    }
+
+    __attribute__((target("avx512f")))
+    static uint32_t matchAvx512(const K* block, K key) {
+        uint32_t mask = 0;
+        if constexpr (sizeof(K) == 4) {
+            const __m512i needle = _mm512_set1_epi32(static_cast<int32_t>(key));
+            for (size_t i = 0; i < BLOCK; i += 16) {
+                __m512i v = _mm512_loadu_si512(block + i);
+                mask |= static_cast<uint32_t>(_mm512_cmpeq_epi32_mask(v, needle)) << i;
+            }
+        } else {
+            const __m512i needle = _mm512_set1_epi64(static_cast<long long>(key));
+            for (size_t i = 0; i < BLOCK; i += 8) {
+                __m512i v = _mm512_loadu_si512(block + i);
+                mask |= static_cast<uint32_t>(_mm512_cmpeq_epi64_mask(v, needle)) << i;
+            }
+        }
+        return mask;
+    }
+#endif
+
+    // Read pass over blocks [first, last): OR the value words of every slot
+    // matching queries[q] into out.selected (one block wide per query).
+    // Inlined into the per-ISA entry points below, so the masked select is
+    // vectorized for that ISA.
+    template<Match match>
+    __attribute__((always_inline))
+    inline void gatherBlocks(size_t first, size_t last, const K* queries, size_t n, ScanPartial& out) const {
+        for (size_t b = first; b < last; ++b) {
+            const K* blockKeys = &keys[b * BLOCK];
+            const uint64_t* blockValues = &values[b * BLOCK_WORDS];
+            uint32_t live = liveBits[b];
+            for (size_t q = 0; q < n; ++q) {
+                uint32_t hits = opaque(match(blockKeys, queries[q]) & live);
+                out.hits[q] |= hits;
+                uint64_t* selected = &out.selected[q * BLOCK_WORDS];
+                for (size_t j = 0; j < BLOCK_WORDS; ++j) {
+                    uint64_t m = static_cast<uint64_t>(0) - ((hits >> (j / VALUE_WORDS)) & 1u);
+                    selected[j] |= blockValues[j] & m;
+                }
+            }
+        }
+    }
+
+    // Write pass over blocks [first, last): for each query in order, the
+    // slot holding its key, or its target slot if it is new, takes the key
+    // and value; every slot is rewritten either way
+    template<Match match>
+    __attribute__((always_inline))
+    inline void scatterBlocks(size_t first, size_t last, const K* queries, const ValueWords* updates,
+                              const size_t* targets, size_t n) {
+        using Word = std::make_unsigned_t<K>;
+        for (size_t b = first; b < last; ++b) {
+            K* blockKeys = &keys[b * BLOCK];
+            uint64_t* blockValues = &values[b * BLOCK_WORDS];
+            uint32_t live = liveBits[b];
+            for (size_t q = 0; q < n; ++q) {
+                size_t offset = targets[q] - b * BLOCK;
+                uint32_t bits = match(blockKeys, queries[q]) & live;
+                bits |= static_cast<uint32_t>(offset < BLOCK) << (offset % BLOCK);
+                bits = opaque(bits);
+                Word key = static_cast<Word>(queries[q]);
+                for (size_t s = 0; s < BLOCK; ++s) {
+                    Word m = static_cast<Word>(0) - static_cast<Word>((bits >> s) & 1u);
+                    blockKeys[s] = static_cast<K>((key & m) | (static_cast<Word>(blockKeys[s]) & ~m));
+                }
+                const ValueWords& update = updates[q];
+                for (size_t j = 0; j < BLOCK_WORDS; ++j) {
+                    uint64_t m = static_cast<uint64_t>(0) - ((bits >> (j / VALUE_WORDS)) & 1u);
+                    blockValues[j] = (update[j % VALUE_WORDS] & m) | (blockValues[j] & ~m);
+                }
+                live |= bits;
+            }
+            liveBits[b] = live;
+        }
+    }
+
+    // Erase pass over blocks [first, last): clear the live bit of the slot
+    // holding key; hits collects the bits cleared
+    template<Match match>
+    __attribute__((always_inline))
+    inline void eraseBlocks(size_t first, size_t last, K key, uint32_t& hits) {
+        for (size_t b = first; b < last; ++b) {
+            uint32_t bits = opaque(match(&keys[b * BLOCK], key) & liveBits[b]);
+            liveBits[b] &= ~bits;
+            hits |= bits;
+        }
+    }
+
+    // Per-ISA entry points
+
+    void gatherBaseline(size_t first, size_t last, const K* queries, size_t n, ScanPartial& out) const {
+        gatherBlocks<matchBaseline>(first, last, queries, n, out);
+    }
+
+    void scatterBaseline(size_t first, size_t last, const K* queries, const ValueWords* updates,
+                         const size_t* targets, size_t n) {
+        scatterBlocks<matchBaseline>(first, last, queries, updates, targets, n);
+    }
+
+    void eraseBaseline(size_t first, size_t last, K key, uint32_t& hits) {
+        eraseBlocks<matchBaseline>(first, last, key, hits);
+    }
+
+#ifdef LINEAR_SCAN_X86_DISPATCH
+    __attribute__((target("avx2")))
+    void gatherAvx2(size_t first, size_t last, const K* queries, size_t n, ScanPartial& out) const {
+        gatherBlocks<matchAvx2>(first, last, queries, n, out);
+    }
+
+    __attribute__((target("avx2")))
+    void scatterAvx2(size_t first, size_t last, const K* queries, const ValueWords* updates,
+                     const size_t* targets, size_t n) {
+        scatterBlocks<matchAvx2>(first, last, queries, updates, targets, n);
+    }
+
+    __attribute__((target("avx2")))
+    void eraseAvx2(size_t first, size_t last, K key, uint32_t& hits) {
+        eraseBlocks<matchAvx2>(first, last, key, hits);
+    }
+
+    __attribute__((target("avx512f")))
+    void gatherAvx512(size_t first, size_t last, const K* queries, size_t n, ScanPartial& out) const {
+        gatherBlocks<matchAvx512>(first, last, queries, n, out);
+    }
+
+    __attribute__((target("avx512f")))
+    void scatterAvx512(size_t first, size_t last, const K* queries, const ValueWords* updates,
+                       const size_t* targets, size_t n) {
+        scatterBlocks<matchAvx512>(first, last, queries, updates, targets, n);
+    }
+
+    __attribute__((target("avx512f")))
+    void eraseAvx512(size_t first, size_t last, K key, uint32_t& hits) {
+        eraseBlocks<matchAvx512>(first, last, key, hits);
+    }
+#endif
+
+    void gather(size_t first, size_t last, const K* queries, size_t n, ScanPartial& out) const {
+#ifdef LINEAR_SCAN_X86_DISPATCH
+        if (isa == ScanIsa::Avx512) {
+            return gatherAvx512(first, last, queries, n, out);
+        }
+        if (isa == ScanIsa::Avx2) {
+            return gatherAvx2(first, last, queries, n, out);
+        }
+#endif
+        gatherBaseline(first, last, queries, n, out);
+    }
+
+    void scatter(size_t first, size_t last, const K* queries, const ValueWords* updates,
+                 const size_t* targets, size_t n) {
+#ifdef LINEAR_SCAN_X86_DISPATCH
+        if (isa == ScanIsa::Avx512) {
+            return scatterAvx512(first, last, queries, updates, targets, n);
+        }
+        if (isa == ScanIsa::Avx2) {
+            return scatterAvx2(first, last, queries, updates, targets, n);
+        }
+#endif
+        scatterBaseline(first, last, queries, updates, targets, n);
+    }
+
+    void erase(size_t first, size_t last, K key, uint32_t& hits) {
+#ifdef LINEAR_SCAN_X86_DISPATCH
+        if (isa == ScanIsa::Avx512) {
+            return eraseAvx512(first, last, key, hits);
+        }
+        if (isa == ScanIsa::Avx2) {
+            return eraseAvx2(first, last, key, hits);
+        }
+#endif
+        eraseBaseline(first, last, key, hits);
+    }
+
+    // Split blocks [0, blocks) into contiguous ranges and call
+    // body(first, last, participant) for each, in parallel once the table
+    // is large enough to pay for waking the pool. Returns the number of
+    // participants used.
+    template<typename Body>
+    size_t forEachRange(size_t blocks, Body&& body) {
+        passes++;
+        size_t parts = blocks >= PARALLEL_MIN_BLOCKS ? workers->size() : 1;
+        if (parts == 1) {
+            body(0, blocks, 0);
+            return 1;
+        }
+        std::function<void(size_t)> task = [&](size_t t) {
+            body(blocks * t / parts, blocks * (t + 1) / parts, t);
+        };
+        workers->run(parts, task);
+        return parts;
+    }
+
+    size_t blocksInUse(size_t slots) const {
+        return (slots + BLOCK - 1) / BLOCK;
+    }
+
+    // One read pass for up to MAX_SCAN_BATCH queries; out may be null when
+    // only found matters
+    void lookupPass(const K* queries, size_t n, ValueType* out, bool* found) {
+        for (ScanPartial& partial : partials) {
+            std::fill_n(partial.selected.begin(), n * BLOCK_WORDS, 0);
+            std::fill_n(partial.hits.begin(), n, 0);
+        }
+        size_t parts = forEachRange(blocksInUse(used), [&](size_t first, size_t last, size_t t) {
+            gather(first, last, queries, n, partials[t]);
+        });
+        for (size_t q = 0; q < n; ++q) {
+            ValueWords words{};
+            uint32_t hits = 0;
+            for (size_t t = 0; t < parts; ++t) {
+                const uint64_t* selected = &partials[t].selected[q * BLOCK_WORDS];
+                for (size_t j = 0; j < BLOCK_WORDS; ++j) {
+                    words[j % VALUE_WORDS] |= selected[j];
+                }
+                hits |= partials[t].hits[q];
+            }
+            if (out) {
+                std::memcpy(out[q].data(), words.data(), ValueSize);
+            }
+            found[q] = hits != 0;
+        }
+    }
+
+    // One read pass to find which keys are new, then one write pass. New
+    // keys take the next unused slots in batch order; a key repeated in the
+    // batch shares the slot of its first occurrence.
+    void updatePass(const K* queries, const ValueType* updates, size_t n) {
+        bool found[MAX_SCAN_BATCH];
+        lookupPass(queries, n, nullptr, found);
+
+        size_t targets[MAX_SCAN_BATCH];
+        size_t added = 0;
+        for (size_t q = 0; q < n; ++q) {
+            targets[q] = found[q] ? NO_SLOT : used + added;
+            for (size_t p = 0; p < q; ++p) {
+                if (!found[q] && queries[p] == queries[q]) {
+                    targets[q] = targets[p];
+                    break;
+                }
+            }
+            added += targets[q] == used + added;
+        }
+        if (used + added > capacity) {
+            grow(std::max(capacity * 2, used + added));
+        }
+
+        ValueWords words[MAX_SCAN_BATCH];
+        for (size_t q = 0; q < n; ++q) {
+            words[q] = loadWords(updates[q]);
+        }
+        forEachRange(blocksInUse(used + added), [&](size_t first, size_t last, size_t) {
+            scatter(first, last, queries, words, targets, n);
+        });
+        used += added;
+        count += added;
+    }
+
+    // Move the used slots into arrays of at least minSlots slots
+    void grow(size_t minSlots) {
+        size_t newCapacity = (minSlots + BLOCK - 1) / BLOCK * BLOCK;
+        ZeroedArray<K> newKeys(newCapacity, memoryPolicy);
+        ZeroedArray<uint32_t> newLive(newCapacity / BLOCK, memoryPolicy);
+        ZeroedArray<uint64_t> newValues(newCapacity * VALUE_WORDS, memoryPolicy);
+        size_t blocks = blocksInUse(used);
+        if (blocks) {
+            std::memcpy(newKeys.begin(), keys.begin(), blocks * BLOCK * sizeof(K));
+            std::memcpy(newLive.begin(), liveBits.begin(), blocks * sizeof(uint32_t));
+            std::memcpy(newValues.begin(), values.begin(), blocks * BLOCK_WORDS * sizeof(uint64_t));
+        }
+        keys = std::move(newKeys);
+        liveBits = std::move(newLive);
+        values = std::move(newValues);
+        capacity = newCapacity;
+    }
+
+    void init(size_t slots) {
+        isa = detectScanIsa();
+        setScanThreads(std::max(1u, std::thread::hardware_concurrency()));
+        grow(std::max<size_t>(slots, BLOCK));
+    }
+
+public:
+    // Table with room for capacity keys before it has to grow
+    explicit LinearScanKVStore(size_t capacity = 1000000, const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory) {
+        init(capacity);
+    }
+
+    // Sized like the hash tables: expectedKeys at maxLoadFactor. A scan
+    // only reads the slots in use, so the spare room costs memory but no
+    // time.
+    LinearScanKVStore(size_t expectedKeys, double maxLoadFactor, const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory) {
+        init(static_cast<size_t>(expectedKeys / maxLoadFactor) + 1);
+    }
+
+    // Threads sharing each pass over large tables (the caller included)
+    void setScanThreads(size_t threads) {
+        threads = std::max<size_t>(threads, 1);
+        workers = std::make_unique<ScanWorkerPool>(threads);
+        partials = std::vector<ScanPartial>(threads);
+    }
+
+    size_t scanThreads() const { return workers->size(); }
+
+    // Instruction set the kernels dispatch to on this CPU
+    ScanIsa scanIsa() const { return isa; }
+
+    // Passes over the table so far (a write costs a read and a write pass)
+    size_t scanPasses() const { return passes; }
+
+    size_t size() const { return count; }
+
+    size_t memoryUsage() const {
+        return keys.capacityBytes() + liveBits.capacityBytes() + values.capacityBytes();
+    }
+
+    // Setup path for initial contents: appends n keys known to be absent
+    // without scanning. Only the new slots are touched, so this is not
+    // oblivious; it is meant for loading data that is public anyway.
+    void append(const K* newKeys, const ValueType* newValues, size_t n) {
+        if (used + n > capacity) {
+            grow(std::max(capacity * 2, used + n));
+        }
+        for (size_t i = 0; i < n; ++i, ++used) {
+            keys[used] = newKeys[i];
+            liveBits[used / BLOCK] |= 1u << (used % BLOCK);
+            ValueWords words = loadWords(newValues[i]);
+            std::memcpy(&values[used * VALUE_WORDS], words.data(), sizeof(words));
+        }
+        count += n;
+    }
+
+    ValueType get(K key) {
+        ValueType result;
+        bool found;
+        lookupPass(&key, 1, &result, &found);
+        return result;
+    }
+
+    // Batched get: out[i] receives the value of keys[i] (all-zero if
+    // absent). Every MAX_SCAN_BATCH keys share one pass over the table.
+    void multiGet(const K* queries, size_t n, ValueType* out) {
+        bool found[MAX_SCAN_BATCH];
+        for (size_t base = 0; base < n; base += MAX_SCAN_BATCH) {
+            lookupPass(queries + base, std::min(MAX_SCAN_BATCH, n - base), out + base, found);
+        }
+    }
+
+    // Batched update (insert if absent) of keys[i] to values[i], in order
+    void multiUpdate(const K* queries, size_t n, const ValueType* updates) {
+        for (size_t base = 0; base < n; base += MAX_SCAN_BATCH) {
+            updatePass(queries + base, updates + base, std::min(MAX_SCAN_BATCH, n - base));
+        }
+    }
+
+    void insert(K key, const ValueType& value) {
+        updatePass(&key, &value, 1);
+    }
+
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        updatePass(&key, &newValue, 1);
+    }
+
+    bool remove(K key) {
+        std::vector<uint32_t> hits(workers->size());
+        size_t parts = forEachRange(blocksInUse(used), [&](size_t first, size_t last, size_t t) {
+            erase(first, last, key, hits[t]);
+        });
+        uint32_t any = 0;
+        for (size_t t = 0; t < parts; ++t) {
+            any |= hits[t];
+        }
+        count -= any != 0;
+        return any != 0;
+    }
+};
+
+#endif // LINEAR_SCAN_KV_STORE_HPP
@@ -0,0 +1,137 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// NUMA nodes with CPUs and the CPUs belonging to each, read from sysfs
+// without libnuma. Hosts (or builds) without that information look like a
+// single node holding every CPU.
+class NumaTopology {
+public:
+    struct Node {
+        int id;                // Kernel node number (not necessarily dense)
+        std::vector<int> cpus;
+    };
+
+private:
+    std::vector<Node> nodes;
+    std::vector<int> cpuNode; // Indexed by CPU
+
+    // Parse a sysfs CPU list such as "0-3,8-11"
+    static std::vector<int> parseCpuList(const std::string& list) {
+        std::vector<int> cpus;
+        size_t pos = 0;
+        while (pos < list.size()) {
+            size_t end = list.find(',', pos);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            std::string range = list.substr(pos, end - pos);
+            size_t dash = range.find('-');
+            try {
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            } catch (const std::exception&) {
+                // Trailing newline or malformed entry
+            }
+            pos = end + 1;
+        }
+        return cpus;
+    }
+
+    NumaTopology() {
+#ifdef __linux__
+        if (DIR* dir = opendir("/sys/devices/system/node")) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+                    name.find_first_not_of("0123456789", 4) != std::string::npos) {
+                    continue;
+                }
+                std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+                std::string list;
+                std::getline(file, list);
+                std::vector<int> cpus = parseCpuList(list);
+                // Memory-only nodes cannot run a worker
+                if (!cpus.empty()) {
+                    nodes.push_back({std::stoi(name.substr(4)), cpus});
+                }
+            }
+            closedir(dir);
+        }
+#endif
+        if (nodes.empty()) {
+            Node all{0, {}};
+            unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < cores; ++cpu) {
+                all.cpus.push_back(static_cast<int>(cpu));
+            }
+            nodes.push_back(all);
+        }
+        std::sort(nodes.begin(), nodes.end(), [](const Node& a, const Node& b) { return a.id < b.id; });
+        for (const Node& node : nodes) {
+            for (int cpu : node.cpus) {
+                if (static_cast<size_t>(cpu) >= cpuNode.size()) {
+                    cpuNode.resize(cpu + 1, -1);
+                }
+                cpuNode[cpu] = node.id;
+            }
+        }
+    }
+
+public:
+    // Topology of this machine, read once
+    static const NumaTopology& system() {
+        static const NumaTopology topology;
+        return topology;
+    }
+
+    size_t nodeCount() const { return nodes.size(); }
+
+    // i-th node in ascending id order, i < nodeCount()
+    const Node& node(size_t i) const { return nodes[i]; }
+
+    // Node id of cpu, or -1 if unknown
+    int nodeOfCpu(size_t cpu) const {
+        return cpu < cpuNode.size() ? cpuNode[cpu] : -1;
+    }
+};
+
+// Restrict the pages of [p, p + bytes) to NUMA node (MPOL_BIND through the
+// raw mbind syscall). p must be page-aligned. Pages already faulted in stay
+// where they are, so bind before first touch. Best effort: false when the
+// kernel refuses or has no NUMA support.
+inline bool bindMemoryToNode(void* p, size_t bytes, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    constexpr int MPOL_BIND_MODE = 2; // MPOL_BIND from <linux/mempolicy.h>
+    constexpr size_t MASK_BITS = 1024;
+    if (node < 0 || static_cast<size_t>(node) >= MASK_BITS) {
+        return false;
+    }
+    unsigned long mask[MASK_BITS / (8 * sizeof(unsigned long))] = {};
+    mask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    return syscall(SYS_mbind, p, bytes, MPOL_BIND_MODE, mask, MASK_BITS + 1, 0) == 0;
+#else
+    (void)p;
+    (void)bytes;
+    (void)node;
+    return false;
+#endif
+}
+
+#endif // NUMA_HPP
@@ -0,0 +1,387 @@
+#ifndef SHARDED_KV_STORE_HPP
+#define SHARDED_KV_STORE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hashing.hpp"
+#include "numa.hpp"
+#include "table_memory.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Bounded lock-free ring for exactly one producer and one consumer thread.
+// Each side caches the other side's index and only reloads it when the ring
+// looks full (producer) or empty (consumer).
+template<typename T, size_t Capacity>
+class SpscRing {
+private:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static constexpr size_t MASK = Capacity - 1;
+
+    alignas(64) std::atomic<size_t> head{0}; // Next slot to read; written by the consumer
+    size_t cachedTail = 0;                   // Consumer's view of tail
+    alignas(64) std::atomic<size_t> tail{0}; // Next slot to write; written by the producer
+    size_t cachedHead = 0;                   // Producer's view of head
+    alignas(64) std::array<T, Capacity> slots;
+
+public:
+    // Producer side; false if the ring is full
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) {
+                return false;
+            }
+        }
+        slots[t & MASK] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; moves up to max items into out and returns how many
+    size_t popBatch(T* out, size_t max) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (cachedTail == h) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (cachedTail == h) {
+                return 0;
+            }
+        }
+        size_t n = std::min(max, cachedTail - h);
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = slots[(h + i) & MASK];
+        }
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+};
+
+// Pin a thread to one core (best effort; a no-op outside Linux)
+inline void pinThreadToCore(std::thread& thread, size_t core) {
+#ifdef __linux__
+    unsigned cores = std::thread::hardware_concurrency();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cores ? core % cores : 0, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+
+// Shared-nothing deployment of any single-threaded store: one Shard per
+// worker thread, each pinned to its own core and owning every key that
+// hashes to it. Client threads never touch a shard; they send requests
+// through a lock-free SPSC ring per (client, shard) pair and receive the
+// replies on a ring going the other way. A shard drains its rings in batches
+// and, when the store has the split-phase API, prefetches a whole batch
+// before executing it in arrival order, so per-key ordering is kept.
+//
+// The NUMA constructor places shards node by node: each node gets a block of
+// shards whose threads run on that node's CPUs and whose tables and values
+// are bound to its memory, so the key space is partitioned across nodes and
+// every operation executes next to its data. Requests are counted as local
+// or remote depending on whether the submitting client runs on the shard's
+// node.
+template<typename Shard>
+class ShardedKVStore {
+public:
+    using KeyType = typename Shard::KeyType;
+    using ValueType = typename Shard::ValueType;
+
+    static constexpr size_t RING_CAPACITY = 256; // Requests in flight per (client, shard) pair
+    static constexpr size_t BATCH_SIZE = 32;     // Requests a shard takes from one ring at a time
+
+    enum class Op : uint8_t { Get, Update, Remove };
+
+    struct Request {
+        Op op;
+        int16_t node; // Submitting client's NUMA node, -1 if unknown
+        KeyType key;
+        uint32_t tag; // Echoed in the response
+        ValueType value;
+    };
+
+    struct Response {
+        uint32_t tag;
+        bool found;      // Get/Remove: key was present (always true for gets on
+                         // shards without the split-phase API)
+        ValueType value; // Get: the value (all-zero if absent)
+    };
+
+    // Per-shard counters, written only by the shard's thread
+    struct ShardStats {
+        uint64_t requests;       // Requests processed
+        uint64_t batches;        // Non-empty ring drains
+        uint64_t localRequests;  // From clients on the shard's node
+        uint64_t remoteRequests; // From clients on another node
+    };
+
+    // One client thread's endpoint. Not thread-safe: each client belongs to
+    // one thread. At most RING_CAPACITY requests may be outstanding, which
+    // guarantees a shard never finds a reply ring full.
+    class Client {
+    public:
+        size_t outstanding() const { return inFlight; }
+
+        // NUMA node the owning thread runs on, for local/remote accounting
+        void setNode(int numaNode) { node = static_cast<int16_t>(numaNode); }
+
+        // False when the owning shard's ring is full or too many requests
+        // are outstanding; poll() and try again
+        bool submit(Op op, KeyType key, uint32_t tag, const ValueType& value = ValueType{}) {
+            if (inFlight == RING_CAPACITY) {
+                return false;
+            }
+            size_t shard = owner.shardOf(key);
+            if (!owner.shards[shard]->requests[index].push(Request{op, node, key, tag, value})) {
+                return false;
+            }
+            inFlight++;
+            return true;
+        }
+
+        // Collect up to max replies from all shards
+        size_t poll(Response* out, size_t max) {
+            size_t n = 0;
+            for (auto& shard : owner.shards) {
+                if (n == max) {
+                    break;
+                }
+                n += shard->responses[index].popBatch(out + n, max - n);
+            }
+            inFlight -= n;
+            return n;
+        }
+
+    private:
+        friend class ShardedKVStore;
+
+        Client(ShardedKVStore& owner, size_t index) : owner(owner), index(index) {}
+
+        ShardedKVStore& owner;
+        size_t index;
+        size_t inFlight = 0;
+        int16_t node = -1;
+    };
+
+    // shardArgs are passed to every shard's constructor
+    template<typename... Args>
+    ShardedKVStore(size_t shardCount, size_t clientCount, const Args&... shardArgs) {
+        for (size_t s = 0; s < shardCount; ++s) {
+            shards.push_back(std::make_unique<ShardState>(clientCount, shardArgs...));
+        }
+        for (size_t c = 0; c < clientCount; ++c) {
+            clients.push_back(std::unique_ptr<Client>(new Client(*this, c)));
+        }
+    }
+
+    // NUMA placement: shardsPerNode shards on every node of topology, each
+    // pinned to one of the node's CPUs (round robin) and built with
+    // shardArgs followed by memory bound to the node (or to memory.numaNode
+    // for every shard when that is set). Shards that do not take a
+    // TableMemoryPolicy are built from shardArgs alone and rely on
+    // first-touch placement by their pinned thread.
+    template<typename... Args>
+    ShardedKVStore(const NumaTopology& topology, size_t shardsPerNode, size_t clientCount,
+                   const TableMemoryPolicy& memory, const Args&... shardArgs) {
+        for (size_t n = 0; n < topology.nodeCount(); ++n) {
+            const auto& node = topology.node(n);
+            TableMemoryPolicy local = memory;
+            if (local.numaNode < 0) {
+                local.numaNode = node.id;
+            }
+            for (size_t i = 0; i < shardsPerNode; ++i) {
+                if constexpr (std::is_constructible_v<Shard, const Args&..., const TableMemoryPolicy&>) {
+                    shards.push_back(std::make_unique<ShardState>(clientCount, shardArgs..., local));
+                } else {
+                    shards.push_back(std::make_unique<ShardState>(clientCount, shardArgs...));
+                }
+                shards.back()->node = node.id;
+                shards.back()->cpu = node.cpus[i % node.cpus.size()];
+            }
+        }
+        for (size_t c = 0; c < clientCount; ++c) {
+            clients.push_back(std::unique_ptr<Client>(new Client(*this, c)));
+        }
+    }
+
+    ShardedKVStore(const ShardedKVStore&) = delete;
+    ShardedKVStore& operator=(const ShardedKVStore&) = delete;
+
+    ~ShardedKVStore() {
+        stop();
+    }
+
+    // Launch the shard threads. Shards placed by the NUMA constructor go to
+    // their CPU; otherwise shard i is pinned to core firstCore + i and takes
+    // that core's node.
+    void start(size_t firstCore = 0) {
+        running.store(true, std::memory_order_release);
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t s = 0; s < shards.size(); ++s) {
+            ShardState& shard = *shards[s];
+            size_t core = shard.cpu >= 0 ? static_cast<size_t>(shard.cpu) : firstCore + s;
+            if (shard.cpu < 0) {
+                shard.node = NumaTopology::system().nodeOfCpu(core % cores);
+            }
+            shard.worker = std::thread([this, &shard] { serve(shard); });
+            pinThreadToCore(shard.worker, core);
+        }
+    }
+
+    // Stop the shard threads once they have drained their rings
+    void stop() {
+        running.store(false, std::memory_order_release);
+        for (auto& shard : shards) {
+            if (shard->worker.joinable()) {
+                shard->worker.join();
+            }
+        }
+    }
+
+    Client& client(size_t i) { return *clients[i]; }
+    size_t shardCount() const { return shards.size(); }
+    size_t clientCount() const { return clients.size(); }
+
+    ShardStats shardStats(size_t s) const {
+        return {shards[s]->processed.load(std::memory_order_relaxed),
+                shards[s]->batches.load(std::memory_order_relaxed),
+                shards[s]->local.load(std::memory_order_relaxed),
+                shards[s]->remote.load(std::memory_order_relaxed)};
+    }
+
+    // NUMA node of shard s, -1 if unknown (before start() for shards not
+    // placed by the NUMA constructor)
+    int shardNode(size_t s) const { return shards[s]->node; }
+
+    // Keys held by shard s; only meaningful while the shards are stopped
+    size_t shardSize(size_t s) const { return shards[s]->store.size(); }
+
+    // Shard owning key: high bits of the key's hash scaled to the shard
+    // count, so routing does not correlate with the shard's own chain index
+    size_t shardOf(KeyType key) const {
+        return FastRange::index(Murmur3Hash::hash(static_cast<uint64_t>(key)), shards.size());
+    }
+
+private:
+    struct ShardState {
+        Shard store;
+        std::vector<SpscRing<Request, RING_CAPACITY>> requests;  // One per client
+        std::vector<SpscRing<Response, RING_CAPACITY>> responses; // One per client
+        std::thread worker;
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> local{0};
+        std::atomic<uint64_t> remote{0};
+        int node = -1; // Set before the worker starts
+        int cpu = -1;  // Fixed CPU from NUMA placement, -1 for start()'s numbering
+
+        template<typename... Args>
+        ShardState(size_t clientCount, const Args&... shardArgs)
+            : store(shardArgs...), requests(clientCount), responses(clientCount) {}
+    };
+
+    template<typename S, typename = void>
+    struct HasSplitPhase : std::false_type {};
+
+    template<typename S>
+    struct HasSplitPhase<S, std::void_t<decltype(std::declval<S&>().prefetchKey(KeyType{}))>> : std::true_type {};
+
+    std::vector<std::unique_ptr<ShardState>> shards;
+    std::vector<std::unique_ptr<Client>> clients;
+    std::atomic<bool> running{false};
+
+    // Execute a batch in arrival order and reply to its client
+    static void process(ShardState& shard, const Request* batch, size_t n, SpscRing<Response, RING_CAPACITY>& replies,
+                        uint64_t& localCount, uint64_t& remoteCount) {
+        uint64_t hashes[BATCH_SIZE];
+        if constexpr (HasSplitPhase<Shard>::value) {
+            for (size_t i = 0; i < n; ++i) {
+                hashes[i] = shard.store.prefetchKey(batch[i].key, batch[i].op != Op::Get);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const Request& request = batch[i];
+            Response response{request.tag, false, ValueType{}};
+            if (request.node >= 0 && shard.node >= 0) {
+                (request.node == shard.node ? localCount : remoteCount)++;
+            }
+            switch (request.op) {
+            case Op::Get:
+                if constexpr (HasSplitPhase<Shard>::value) {
+                    if (const ValueType* value = shard.store.find(request.key, hashes[i])) {
+                        response.found = true;
+                        response.value = *value;
+                    }
+                } else {
+                    response.value = shard.store.get(request.key);
+                    response.found = true;
+                }
+                break;
+            case Op::Update:
+                shard.store.update(request.key, request.value);
+                break;
+            case Op::Remove:
+                response.found = shard.store.remove(request.key);
+                break;
+            }
+            // Cannot fail: the client caps its outstanding requests at the
+            // ring capacity
+            replies.push(response);
+        }
+    }
+
+    void serve(ShardState& shard) {
+        Request batch[BATCH_SIZE];
+        unsigned idle = 0;
+        for (;;) {
+            // Sample the flag before draining so requests submitted before
+            // stop() are still served
+            bool stopping = !running.load(std::memory_order_acquire);
+            size_t handled = 0;
+            uint64_t localCount = 0;
+            uint64_t remoteCount = 0;
+            for (size_t c = 0; c < shard.requests.size(); ++c) {
+                size_t n = shard.requests[c].popBatch(batch, BATCH_SIZE);
+                if (n) {
+                    process(shard, batch, n, shard.responses[c], localCount, remoteCount);
+                    shard.batches.store(shard.batches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    handled += n;
+                }
+            }
+            shard.processed.store(shard.processed.load(std::memory_order_relaxed) + handled,
+                                  std::memory_order_relaxed);
+            if (localCount | remoteCount) {
+                shard.local.store(shard.local.load(std::memory_order_relaxed) + localCount, std::memory_order_relaxed);
+                shard.remote.store(shard.remote.load(std::memory_order_relaxed) + remoteCount, std::memory_order_relaxed);
+            }
+            if (handled) {
+                idle = 0;
+            } else if (stopping) {
+                return;
+            } else if (++idle >= 64) {
+                // Give the core away when there is nothing to do (matters when
+                // shards and clients share cores)
+                idle = 0;
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+#endif // SHARDED_KV_STORE_HPP
@@ -0,0 +1,107 @@
+#ifndef SIMD_MATCH_HPP
+#define SIMD_MATCH_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Bitmask of the slots in keys[0..N) equal to key (bit i <=> keys[i] == key).
+// Every slot is compared on every call: the work does not depend on where, or
+// whether, the key matches. 4- and 8-byte keys use AVX2 when compiled in,
+// then SSE2; anything left over falls back to a scalar loop.
+template<typename K, size_t N>
+inline uint32_t matchKeyMask(const K* keys, K key) {
+    static_assert(N <= 32, "match mask holds at most 32 slots");
+    uint32_t mask = 0;
+    size_t i = 0;
+
+    // Vector loops cover whole vectors only; their bounds are compile-time
+    // constants
+#if defined(__AVX2__)
+    constexpr size_t avx2Lanes = 32 / sizeof(K);
+    if constexpr (sizeof(K) == 4) {
+        int32_t bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        const __m256i needle = _mm256_set1_epi32(bits);
+        for (; i < N / avx2Lanes * avx2Lanes; i += avx2Lanes) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+            __m256i eq = _mm256_cmpeq_epi32(v, needle);
+            mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(eq))) << i;
+        }
+    } else if constexpr (sizeof(K) == 8) {
+        long long bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        const __m256i needle = _mm256_set1_epi64x(bits);
+        for (; i < N / avx2Lanes * avx2Lanes; i += avx2Lanes) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+            __m256i eq = _mm256_cmpeq_epi64(v, needle);
+            mask |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(eq))) << i;
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    constexpr size_t sse2Lanes = 16 / sizeof(K);
+    if constexpr (sizeof(K) == 4) {
+        int32_t bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        const __m128i needle = _mm_set1_epi32(bits);
+        for (; i < N / sse2Lanes * sse2Lanes; i += sse2Lanes) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+            __m128i eq = _mm_cmpeq_epi32(v, needle);
+            mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+        }
+    } else if constexpr (sizeof(K) == 8) {
+        long long bits;
+        std::memcpy(&bits, &key, sizeof(bits));
+        const __m128i needle = _mm_set1_epi64x(bits);
+        for (; i < N / sse2Lanes * sse2Lanes; i += sse2Lanes) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+            // SSE2 has no 64-bit compare: both 32-bit halves must match
+            __m128i eq = _mm_cmpeq_epi32(v, needle);
+            eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+            mask |= static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(eq))) << i;
+        }
+    }
+#endif
+
+    // Scalar fallback (other key sizes, non-x86 targets, and the tail)
+    for (; i < N; ++i) {
+        mask |= static_cast<uint32_t>(keys[i] == key) << i;
+    }
+    return mask;
+}
+
+// Bitmask of the 16 control bytes equal to tag (SSE2 when available)
+inline uint32_t matchByteMask(const int8_t* ctrl, int8_t tag) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(tag))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < 16; ++i) {
+        mask |= static_cast<uint32_t>(ctrl[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+// Bitmask of the 16 control bytes with the sign bit set
+inline uint32_t signByteMask(const int8_t* ctrl) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(v));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < 16; ++i) {
+        mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+#endif // SIMD_MATCH_HPP
@@ -0,0 +1,298 @@
+#ifndef SLAB_ALLOCATOR_HPP
+#define SLAB_ALLOCATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+#include <sys/mman.h>
+
+#include "table_memory.hpp"
+
+// Fixed-size slot allocator for out-of-line values. Slots are carved from
+// large anonymous mappings with a bump pointer; freed slots go onto an
+// intrusive free list and are handed out again first. Nothing is returned
+// to the kernel until the allocator is destroyed, which unmaps every region
+// without visiting individual slots.
+template<size_t SlotSize, size_t SlotAlign = alignof(std::max_align_t)>
+class SlabAllocator {
+private:
+    // Slots double as free-list nodes, so they hold at least a pointer
+    static constexpr size_t ALIGN = SlotAlign > alignof(void*) ? SlotAlign : alignof(void*);
+    static constexpr size_t STRIDE = ((SlotSize > sizeof(void*) ? SlotSize : sizeof(void*)) + ALIGN - 1) / ALIGN * ALIGN;
+
+    // Regions are whole huge pages holding at least 64 slots
+    static constexpr size_t REGION_BYTES = (STRIDE * 64 + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    struct Region {
+        void* mapping;
+        size_t bytes;
+    };
+
+    std::vector<Region> regions;
+    char* bump = nullptr;
+    char* bumpEnd = nullptr;
+    FreeSlot* freeList = nullptr;
+    size_t live = 0;
+    TableMemoryPolicy policy;
+
+    // Map a new region (following the memory policy) and point the bump
+    // allocator at it
+    void grow() {
+        size_t bytes = REGION_BYTES;
+        HugePages obtained;
+        void* p = mapTableMemory(bytes, policy, obtained);
+        regions.push_back({p, bytes});
+        bump = static_cast<char*>(p);
+        bumpEnd = bump + REGION_BYTES / STRIDE * STRIDE;
+    }
+
+    void release() {
+        for (const Region& region : regions) {
+            munmap(region.mapping, region.bytes);
+        }
+        regions.clear();
+        bump = bumpEnd = nullptr;
+        freeList = nullptr;
+        live = 0;
+    }
+
+public:
+    explicit SlabAllocator(const TableMemoryPolicy& policy = {}) : policy(policy) {}
+
+    SlabAllocator(SlabAllocator&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SlabAllocator& operator=(SlabAllocator&& other) noexcept {
+        if (this != &other) {
+            release();
+            regions = std::move(other.regions);
+            other.regions.clear();
+            bump = std::exchange(other.bump, nullptr);
+            bumpEnd = std::exchange(other.bumpEnd, nullptr);
+            freeList = std::exchange(other.freeList, nullptr);
+            live = std::exchange(other.live, 0);
+            policy = other.policy;
+        }
+        return *this;
+    }
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    ~SlabAllocator() {
+        release();
+    }
+
+    // Uninitialized slot of SlotSize bytes
+    void* allocate() {
+        live++;
+        if (freeList) {
+            FreeSlot* slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        if (bump == bumpEnd) {
+            grow();
+        }
+        void* slot = bump;
+        bump += STRIDE;
+        return slot;
+    }
+
+    // Return a slot obtained from allocate()
+    void deallocate(void* p) {
+        FreeSlot* slot = static_cast<FreeSlot*>(p);
+        slot->next = freeList;
+        freeList = slot;
+        live--;
+    }
+
+    size_t liveSlots() const { return live; }
+
+    // Bytes mapped for slots, used or not
+    size_t capacityBytes() const { return regions.size() * REGION_BYTES; }
+};
+
+// Slot allocator for variable-size payloads. Requests are rounded up to a
+// size class (powers of two and the midpoints between them, MIN_SLOT to
+// MAX_SLOT bytes), so at most a third of a slot is wasted. Each class
+// carves its slots from its own huge-page regions with a bump pointer and
+// reuses freed slots first, like SlabAllocator. Anything larger than
+// MAX_SLOT gets its own heap block, linked into a list so the allocator can
+// still free everything on destruction.
+class SizeClassAllocator {
+public:
+    static constexpr size_t MIN_SLOT = 16;
+    static constexpr size_t MAX_SLOT = 64 << 10;
+    static constexpr size_t CLASS_COUNT = 25; // 16, 24, 32, 48, ..., 48K, 64K
+
+private:
+    static constexpr size_t REGION_BYTES = HUGE_PAGE_BYTES; // Holds at least 32 slots of any class
+
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    struct Region {
+        void* mapping;
+        size_t bytes;
+    };
+
+    struct SizeClass {
+        char* bump = nullptr;
+        char* bumpEnd = nullptr;
+        FreeSlot* freeList = nullptr;
+    };
+
+    // Header in front of an oversized slot
+    struct alignas(16) LargeSlot {
+        LargeSlot* prev;
+        LargeSlot* next;
+    };
+
+    std::array<SizeClass, CLASS_COUNT> classes{};
+    std::vector<Region> regions;
+    LargeSlot* largeSlots = nullptr;
+    size_t live = 0;
+    size_t largeBytes = 0;
+    TableMemoryPolicy policy;
+
+    void grow(SizeClass& sizeClass, size_t stride) {
+        size_t bytes = REGION_BYTES;
+        HugePages obtained;
+        void* p = mapTableMemory(bytes, policy, obtained);
+        regions.push_back({p, bytes});
+        sizeClass.bump = static_cast<char*>(p);
+        sizeClass.bumpEnd = sizeClass.bump + REGION_BYTES / stride * stride;
+    }
+
+    void release() {
+        for (const Region& region : regions) {
+            munmap(region.mapping, region.bytes);
+        }
+        regions.clear();
+        while (largeSlots) {
+            std::free(std::exchange(largeSlots, largeSlots->next));
+        }
+        classes = {};
+        live = 0;
+        largeBytes = 0;
+    }
+
+public:
+    explicit SizeClassAllocator(const TableMemoryPolicy& policy = {}) : policy(policy) {}
+
+    SizeClassAllocator(SizeClassAllocator&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    SizeClassAllocator& operator=(SizeClassAllocator&& other) noexcept {
+        if (this != &other) {
+            release();
+            regions = std::move(other.regions);
+            other.regions.clear();
+            classes = std::exchange(other.classes, {});
+            largeSlots = std::exchange(other.largeSlots, nullptr);
+            live = std::exchange(other.live, 0);
+            largeBytes = std::exchange(other.largeBytes, 0);
+            policy = other.policy;
+        }
+        return *this;
+    }
+
+    SizeClassAllocator(const SizeClassAllocator&) = delete;
+    SizeClassAllocator& operator=(const SizeClassAllocator&) = delete;
+
+    ~SizeClassAllocator() {
+        release();
+    }
+
+    // Size class of a bytes-long slot, CLASS_COUNT if it is oversized
+    static size_t classOf(size_t bytes) {
+        if (bytes <= MIN_SLOT) {
+            return 0;
+        }
+        if (bytes > MAX_SLOT) {
+            return CLASS_COUNT;
+        }
+        // bytes is in (2^p, 2^(p+1)]: the midpoint class or the next power
+        size_t p = 63 - __builtin_clzll(bytes - 1);
+        size_t power = static_cast<size_t>(1) << p;
+        return bytes <= power + power / 2 ? 2 * (p - 4) + 1 : 2 * (p - 3);
+    }
+
+    // Bytes of a slot of class c < CLASS_COUNT
+    static size_t classSize(size_t c) {
+        size_t power = MIN_SLOT << (c / 2);
+        return c % 2 ? power + power / 2 : power;
+    }
+
+    // Uninitialized slot of at least bytes bytes, aligned to 8 (16 for
+    // class sizes that are multiples of 16)
+    void* allocate(size_t bytes) {
+        live++;
+        size_t c = classOf(bytes);
+        if (c == CLASS_COUNT) {
+            LargeSlot* slot = static_cast<LargeSlot*>(std::malloc(sizeof(LargeSlot) + bytes));
+            if (!slot) {
+                live--;
+                throw std::bad_alloc();
+            }
+            slot->prev = nullptr;
+            slot->next = largeSlots;
+            if (largeSlots) {
+                largeSlots->prev = slot;
+            }
+            largeSlots = slot;
+            largeBytes += sizeof(LargeSlot) + bytes;
+            return slot + 1;
+        }
+        SizeClass& sizeClass = classes[c];
+        if (sizeClass.freeList) {
+            FreeSlot* slot = sizeClass.freeList;
+            sizeClass.freeList = slot->next;
+            return slot;
+        }
+        if (sizeClass.bump == sizeClass.bumpEnd) {
+            grow(sizeClass, classSize(c));
+        }
+        void* slot = sizeClass.bump;
+        sizeClass.bump += classSize(c);
+        return slot;
+    }
+
+    // Return a slot from allocate(bytes), with the same bytes
+    void deallocate(void* p, size_t bytes) {
+        live--;
+        size_t c = classOf(bytes);
+        if (c == CLASS_COUNT) {
+            LargeSlot* slot = static_cast<LargeSlot*>(p) - 1;
+            (slot->prev ? slot->prev->next : largeSlots) = slot->next;
+            if (slot->next) {
+                slot->next->prev = slot->prev;
+            }
+            std::free(slot);
+            largeBytes -= sizeof(LargeSlot) + bytes;
+            return;
+        }
+        FreeSlot* slot = static_cast<FreeSlot*>(p);
+        slot->next = classes[c].freeList;
+        classes[c].freeList = slot;
+    }
+
+    size_t liveSlots() const { return live; }
+
+    // Bytes mapped for class slots, used or not, plus live oversized slots
+    size_t capacityBytes() const { return regions.size() * REGION_BYTES + largeBytes; }
+};
+
+#endif // SLAB_ALLOCATOR_HPP
@@ -0,0 +1,212 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk store snapshots. A snapshot is a fixed header page followed by
+// raw store sections at offsets recorded in the header; sections that get
+// mapped start on a page boundary. Nothing in a section is a pointer, so a
+// snapshot can be mapped at any address and used in place.
+
+// How an opened snapshot's mapped sections may be used
+enum class SnapshotMode {
+    ReadOnly,   // Shared read-only pages straight from the page cache; writing faults
+    CopyOnWrite // Private pages: writes copy the touched page and never reach the file
+};
+
+constexpr size_t SNAPSHOT_PAGE_BYTES = 4096;
+constexpr char SNAPSHOT_MAGIC[8] = {'K', 'V', 'S', 'N', 'A', 'P', '0', '1'};
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304; // Reads back differently on the other byte order
+
+// First page of every snapshot. The layout fields pin down everything the
+// sections depend on, so a snapshot written by a different instantiation
+// (or ABI) is rejected instead of misread.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+
+    // Layout of the store that wrote the snapshot
+    uint32_t keyBytes;
+    uint32_t valueBytes;
+    uint32_t chainSize;
+    uint32_t stashSize;
+    uint32_t chainBytes;  // sizeof one chain
+    uint32_t stashBytes;  // sizeof the stash
+    uint32_t hashPolicy;  // Traits::Hash::ID
+    uint32_t rangePolicy; // Traits::Range::ID
+
+    // Store state
+    uint64_t tableSize;   // Chains
+    uint64_t count;       // Live keys
+    double maxLoadFactor;
+    uint64_t stashPeak;
+    uint64_t stashOverflows;
+
+    // Sections (byte offsets from the start of the file)
+    uint64_t stashOffset;
+    uint64_t tableOffset; // Page-aligned
+    uint64_t tableBytes;
+};
+
+static_assert(sizeof(SnapshotHeader) <= SNAPSHOT_PAGE_BYTES, "the header fits its page");
+
+inline size_t snapshotPageAlign(size_t bytes) {
+    return (bytes + SNAPSHOT_PAGE_BYTES - 1) / SNAPSHOT_PAGE_BYTES * SNAPSHOT_PAGE_BYTES;
+}
+
+inline std::runtime_error snapshotError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// Sequential writer for a new snapshot. The file is written under a
+// temporary name and renamed over path by commit(), so readers never see a
+// partial snapshot; dropping the writer without committing removes it.
+class SnapshotWriter {
+private:
+    std::string path;
+    std::string tempPath;
+    int fd = -1;
+    uint64_t offset = 0;
+
+public:
+    explicit SnapshotWriter(const std::string& path) : path(path), tempPath(path + ".tmp") {
+        fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw snapshotError("cannot create snapshot", tempPath);
+        }
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    ~SnapshotWriter() {
+        if (fd >= 0) {
+            ::close(fd);
+            ::unlink(tempPath.c_str());
+        }
+    }
+
+    // Bytes written so far
+    uint64_t position() const { return offset; }
+
+    void write(const void* data, size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t n = ::write(fd, p, bytes);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw snapshotError("cannot write snapshot", tempPath);
+            }
+            p += n;
+            bytes -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+    }
+
+    // Zero-fill up to the next multiple of alignment
+    void pad(size_t alignment) {
+        static const char zeros[SNAPSHOT_PAGE_BYTES] = {};
+        size_t bytes = (alignment - offset % alignment) % alignment;
+        while (bytes > 0) {
+            size_t chunk = bytes < sizeof(zeros) ? bytes : sizeof(zeros);
+            write(zeros, chunk);
+            bytes -= chunk;
+        }
+    }
+
+    void commit() {
+        if (::fsync(fd) != 0 || ::close(fd) != 0) {
+            fd = -1;
+            ::unlink(tempPath.c_str());
+            throw snapshotError("cannot flush snapshot", tempPath);
+        }
+        fd = -1;
+        if (::rename(tempPath.c_str(), path.c_str()) != 0) {
+            ::unlink(tempPath.c_str());
+            throw snapshotError("cannot rename snapshot to", path);
+        }
+    }
+};
+
+// Read side of a snapshot: the header is read and checked against the
+// expected layout on construction, sections are read or mapped on demand
+class SnapshotReader {
+private:
+    std::string path;
+    int fd = -1;
+    uint64_t fileBytes = 0;
+    SnapshotHeader header{};
+
+public:
+    explicit SnapshotReader(const std::string& path) : path(path) {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw snapshotError("cannot open snapshot", path);
+        }
+        try {
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                throw snapshotError("cannot stat snapshot", path);
+            }
+            fileBytes = static_cast<uint64_t>(st.st_size);
+            read(0, &header, sizeof(header));
+            if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+                header.version != SNAPSHOT_VERSION || header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+                throw std::runtime_error("not a snapshot of this version and byte order: " + path);
+            }
+            if (header.stashOffset + header.stashBytes > fileBytes ||
+                header.tableOffset % SNAPSHOT_PAGE_BYTES != 0 ||
+                header.tableOffset + header.tableBytes > fileBytes) {
+                throw std::runtime_error("truncated snapshot: " + path);
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    ~SnapshotReader() {
+        ::close(fd);
+    }
+
+    const SnapshotHeader& info() const { return header; }
+
+    // Copy bytes at offset into out
+    void read(uint64_t offset, void* out, size_t bytes) const {
+        if (offset + bytes > fileBytes ||
+            ::pread(fd, out, bytes, static_cast<off_t>(offset)) != static_cast<ssize_t>(bytes)) {
+            throw snapshotError("cannot read snapshot", path);
+        }
+    }
+
+    // Map bytes at a page-aligned offset; released with munmap. Pages are
+    // faulted in from the page cache on first touch, so this costs the same
+    // for any size.
+    void* map(uint64_t offset, size_t bytes, SnapshotMode mode) const {
+        int prot = mode == SnapshotMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        int flags = mode == SnapshotMode::ReadOnly ? MAP_SHARED : MAP_PRIVATE;
+        void* p = ::mmap(nullptr, bytes, prot, flags, fd, static_cast<off_t>(offset));
+        if (p == MAP_FAILED) {
+            throw snapshotError("cannot map snapshot", path);
+        }
+        return p;
+    }
+};
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,236 @@
+#ifndef SWISS_KV_STORE_HPP
+#define SWISS_KV_STORE_HPP
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+#include "kvstore.hpp"
+#include "simd_match.hpp"
+
+// Open-addressing KV store in the style of Abseil's Swiss tables. Slots are
+// grouped 16 at a time behind one control byte each (empty, deleted, or a
+// 7-bit tag of the hash); a probe matches a whole group of tags with a single
+// SIMD compare and only then looks at the candidate keys. Exposes the same
+// get/insert/update/remove surface as KVStore so both engines can be
+// benchmarked through the same code.
+template<typename K, size_t ValueSize, typename Traits = KVStoreTraits<K, ValueSize>>
+class SwissKVStore {
+private:
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr int8_t CTRL_EMPTY = -128;  // 0b10000000
+    static constexpr int8_t CTRL_DELETED = -2;  // 0b11111110
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+    
+    // Maximum load factor before the table grows (7/8)
+    static constexpr size_t MAX_LOAD_NUM = 7;
+    static constexpr size_t MAX_LOAD_DEN = 8;
+
+    using Storage = typename Traits::Storage;
+    
+    struct alignas(16) Group {
+        std::array<int8_t, GROUP_SIZE> ctrl;
+        
+        Group() { ctrl.fill(CTRL_EMPTY); }
+    };
+    
+    std::vector<Group> groups;
+    std::vector<K> keys;
+    std::vector<Storage> values;
+    typename Storage::Arena valueArena; // Out-of-line value slots
+    size_t groupMask;
+    size_t capacity;
+    size_t used; // Full plus deleted slots; bounds the probe length
+    size_t count = 0; // Live keys
+    
+    static uint64_t hash(K key) {
+        return Traits::Hash::hash(static_cast<uint64_t>(key));
+    }
+    
+    // Low 7 bits select the tag, the rest the starting group
+    static int8_t tagOf(uint64_t h) { return static_cast<int8_t>(h & 0x7F); }
+    size_t groupOf(uint64_t h) const { return static_cast<size_t>(h >> 7) & groupMask; }
+    
+    size_t find(K key, uint64_t h) const {
+        const int8_t tag = tagOf(h);
+        size_t g = groupOf(h);
+        // Triangular probing visits every group once for power-of-two counts
+        for (size_t step = 1; step <= groups.size(); ++step) {
+            const int8_t* ctrl = groups[g].ctrl.data();
+            for (uint32_t m = matchByteMask(ctrl, tag); m; m &= m - 1) {
+                size_t slot = g * GROUP_SIZE + __builtin_ctz(m);
+                if (keys[slot] == key) {
+                    return slot;
+                }
+            }
+            // A group with an empty slot terminates every probe through it
+            if (matchByteMask(ctrl, CTRL_EMPTY)) {
+                return NOT_FOUND;
+            }
+            g = (g + step) & groupMask;
+        }
+        return NOT_FOUND;
+    }
+    
+    // First empty or deleted slot along the probe sequence of h
+    size_t findFree(uint64_t h) const {
+        size_t g = groupOf(h);
+        for (size_t step = 1; ; ++step) {
+            uint32_t m = signByteMask(groups[g].ctrl.data());
+            if (m) {
+                return g * GROUP_SIZE + __builtin_ctz(m);
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+    
+    void allocate(size_t slots) {
+        capacity = std::max(GROUP_SIZE, nextPowerOfTwo(slots));
+        groups.assign(capacity / GROUP_SIZE, Group());
+        keys.assign(capacity, K());
+        values.clear();
+        values.resize(capacity);
+        groupMask = capacity / GROUP_SIZE - 1;
+        used = 0;
+    }
+    
+    // Rebuild into a table of the given size, dropping tombstones
+    void rehash(size_t newCapacity) {
+        std::vector<Group> oldGroups = std::move(groups);
+        std::vector<K> oldKeys = std::move(keys);
+        std::vector<Storage> oldValues = std::move(values);
+        allocate(newCapacity);
+        
+        for (size_t slot = 0; slot < oldKeys.size(); ++slot) {
+            if (oldGroups[slot / GROUP_SIZE].ctrl[slot % GROUP_SIZE] >= 0) {
+                uint64_t h = hash(oldKeys[slot]);
+                size_t dst = findFree(h);
+                groups[dst / GROUP_SIZE].ctrl[dst % GROUP_SIZE] = tagOf(h);
+                keys[dst] = oldKeys[slot];
+                values[dst] = std::move(oldValues[slot]);
+                used++;
+            }
+        }
+    }
+    
+    static size_t nextPowerOfTwo(size_t n) {
+        size_t p = 1;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+    
+    void store(K key, const std::array<uint8_t, ValueSize>& value) {
+        uint64_t h = hash(key);
+        size_t slot = find(key, h);
+        if (slot != NOT_FOUND) {
+            values[slot].write(value, valueArena);
+            return;
+        }
+        
+        if ((used + 1) * MAX_LOAD_DEN > capacity * MAX_LOAD_NUM) {
+            // Grow unless most of the used slots are tombstones
+            rehash(size() * 2 * MAX_LOAD_DEN > capacity * MAX_LOAD_NUM ? capacity * 2 : capacity);
+        }
+        
+        slot = findFree(h);
+        int8_t& ctrl = groups[slot / GROUP_SIZE].ctrl[slot % GROUP_SIZE];
+        if (ctrl == CTRL_EMPTY) {
+            used++;
+        }
+        ctrl = tagOf(h);
+        keys[slot] = key;
+        values[slot].write(value, valueArena);
+        count++;
+    }
+
+public:
+    using KeyType = K;
+    using ValueType = std::array<uint8_t, ValueSize>;
+    
+    // Constructor that sizes the table for dataSize keys below the max load
+    SwissKVStore(size_t dataSize = 1000000) {
+        allocate(dataSize * MAX_LOAD_DEN / MAX_LOAD_NUM + 1);
+    }
+    
+    // Constructor that sizes the table so expectedKeys fill at most
+    // maxLoadFactor of the slots (capped at the growth threshold)
+    SwissKVStore(size_t expectedKeys, double maxLoadFactor) {
+        double load = std::min(maxLoadFactor, static_cast<double>(MAX_LOAD_NUM) / MAX_LOAD_DEN);
+        allocate(static_cast<size_t>(expectedKeys / load) + 1);
+    }
+    
+    size_t size() const { return count; }
+    
+    // Bytes held by the control bytes, keys, value slots and value slabs
+    size_t memoryUsage() const {
+        return groups.capacity() * sizeof(Group) + keys.capacity() * sizeof(K) +
+               values.capacity() * sizeof(Storage) + valueArena.capacityBytes();
+    }
+    
+    ValueType get(K key) {
+        size_t slot = find(key, hash(key));
+        if (slot != NOT_FOUND && values[slot].hasValue()) {
+            return values[slot].read();
+        }
+        return ValueType{};  // Empty array if not found
+    }
+    
+    // Copy the value of key to dst (ValueSize bytes); false, leaving dst
+    // alone, if key is absent
+    bool getInto(K key, uint8_t* dst) const {
+        size_t slot = find(key, hash(key));
+        if (slot == NOT_FOUND || !values[slot].hasValue()) {
+            return false;
+        }
+        std::memcpy(dst, values[slot].read().data(), ValueSize);
+        return true;
+    }
+    
+    // Call f(const ValueType&) on the value of key in place; false without
+    // calling f if key is absent. f must not modify the store.
+    template<typename F>
+    bool visit(K key, F&& f) const {
+        size_t slot = find(key, hash(key));
+        if (slot == NOT_FOUND || !values[slot].hasValue()) {
+            return false;
+        }
+        std::forward<F>(f)(values[slot].read());
+        return true;
+    }
+    
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+    
+    bool remove(K key) {
+        size_t slot = find(key, hash(key));
+        if (slot == NOT_FOUND) {
+            return false;
+        }
+        
+        // Probes stop at any group holding an empty slot, so the slot can go
+        // straight back to empty if its group already has one
+        auto& group = groups[slot / GROUP_SIZE];
+        if (matchByteMask(group.ctrl.data(), CTRL_EMPTY)) {
+            group.ctrl[slot % GROUP_SIZE] = CTRL_EMPTY;
+            used--;
+        } else {
+            group.ctrl[slot % GROUP_SIZE] = CTRL_DELETED;
+        }
+        values[slot].release(valueArena);
+        count--;
+        return true;
+    }
+    
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
+    }
+};
+
+#endif // SWISS_KV_STORE_HPP
@@ -0,0 +1,218 @@
+#ifndef TABLE_MEMORY_HPP
+#define TABLE_MEMORY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <sys/mman.h>
+
+#include "numa.hpp"
+
+// Page backing for large table allocations
+enum class HugePages {
+    Off,         // Regular 4 KB pages
+    Transparent, // madvise(MADV_HUGEPAGE): the kernel may back the range with 2 MB pages
+    Explicit     // MAP_HUGETLB from the reserved pool, falling back to Transparent
+};
+
+// Runtime memory options for table and value allocations
+struct TableMemoryPolicy {
+    HugePages hugePages = HugePages::Off;
+    bool prefault = false; // Touch every page at allocation instead of on first use
+    int numaNode = -1;     // Bind the pages to this NUMA node; -1 leaves placement to first touch
+};
+
+constexpr size_t HUGE_PAGE_BYTES = 2 << 20;
+
+// Map bytes of zeroed memory following policy. Huge-page mappings are
+// rounded up to whole 2 MB pages (bytes is updated) and start on a 2 MB
+// boundary; obtained reports the backing actually used. A NUMA node in the
+// policy is bound before any page is touched. The result is released with
+// munmap(result, bytes).
+inline void* mapTableMemory(size_t& bytes, const TableMemoryPolicy& policy, HugePages& obtained) {
+    obtained = HugePages::Off;
+    void* p = MAP_FAILED;
+    if (policy.hugePages != HugePages::Off) {
+        bytes = (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+    }
+    
+#ifdef MAP_HUGETLB
+    if (policy.hugePages == HugePages::Explicit) {
+        // Fails unless enough pages are reserved (vm.nr_hugepages)
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            obtained = HugePages::Explicit;
+        }
+    }
+#endif
+    
+    if (p == MAP_FAILED && policy.hugePages != HugePages::Off) {
+        // Over-map so the range can be trimmed to a 2 MB-aligned start
+        size_t span = bytes + HUGE_PAGE_BYTES;
+        void* raw = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        size_t head = (HUGE_PAGE_BYTES - start % HUGE_PAGE_BYTES) % HUGE_PAGE_BYTES;
+        if (head) {
+            munmap(raw, head);
+        }
+        munmap(static_cast<char*>(raw) + head + bytes, HUGE_PAGE_BYTES - head);
+        p = static_cast<char*>(raw) + head;
+#ifdef MADV_HUGEPAGE
+        if (madvise(p, bytes, MADV_HUGEPAGE) == 0) {
+            obtained = HugePages::Transparent;
+        }
+#endif
+    }
+    
+    if (p == MAP_FAILED) {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+    }
+    
+    if (policy.numaNode >= 0) {
+        bindMemoryToNode(p, bytes, policy.numaNode);
+    }
+    
+    if (policy.prefault) {
+        // Fault every page in now; writing zero keeps the contents
+        volatile char* bytesPtr = static_cast<char*>(p);
+        for (size_t offset = 0; offset < bytes; offset += 4096) {
+            bytesPtr[offset] = 0;
+        }
+    }
+    return p;
+}
+
+inline const char* hugePagesName(HugePages mode) {
+    switch (mode) {
+    case HugePages::Transparent: return "transparent";
+    case HugePages::Explicit: return "explicit";
+    default: return "off";
+    }
+}
+
+// Fixed-size array whose elements start out as all-zero bytes. Large arrays
+// are mapped straight from the kernel, so their pages are zeroed lazily on
+// first touch instead of being written up front; allocating a big table is
+// then close to free and its cost is spread over the operations that use it.
+// T must treat all-zero bytes as its empty state (zero keys and masks,
+// zeroed inline values, null pointers). A TableMemoryPolicy can back large
+// arrays with huge pages and fault them in up front; arrays bound to a NUMA
+// node are always mapped, whatever their size.
+template<typename T>
+class ZeroedArray {
+private:
+    static constexpr size_t MMAP_THRESHOLD = 1 << 20; // Bytes
+    
+    T* elements = nullptr;
+    size_t count = 0;
+    size_t bytes = 0;
+    bool mapped = false;
+    HugePages backing = HugePages::Off;
+    
+    void release() {
+        if (!elements) {
+            return;
+        }
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < count; ++i) {
+                elements[i].~T();
+            }
+        }
+        if (mapped) {
+            munmap(elements, bytes);
+        } else {
+            std::free(elements);
+        }
+        elements = nullptr;
+        count = 0;
+        bytes = 0;
+    }
+    
+public:
+    ZeroedArray() = default;
+    
+    explicit ZeroedArray(size_t n, const TableMemoryPolicy& policy = {}) : count(n) {
+        if (n == 0) {
+            return;
+        }
+        // Round up to whole alignment units (aligned_alloc requires it)
+        constexpr size_t align = std::max(alignof(T), sizeof(void*));
+        bytes = (n * sizeof(T) + align - 1) / align * align;
+        if (bytes >= MMAP_THRESHOLD || policy.numaNode >= 0) {
+            elements = static_cast<T*>(mapTableMemory(bytes, policy, backing));
+            mapped = true;
+        } else {
+            void* p = std::aligned_alloc(align, bytes);
+            if (!p) {
+                throw std::bad_alloc();
+            }
+            std::memset(p, 0, bytes);
+            elements = static_cast<T*>(p);
+        }
+    }
+    
+    // Take over n elements at the start of an existing mapping of bytes
+    // bytes (from mmap; released with munmap). The contents are whatever the
+    // mapping holds, e.g. a table mapped from a snapshot file.
+    static ZeroedArray adoptMapping(void* mapping, size_t n, size_t bytes) {
+        ZeroedArray array;
+        array.elements = static_cast<T*>(mapping);
+        array.count = n;
+        array.bytes = bytes;
+        array.mapped = true;
+        return array;
+    }
+    
+    ZeroedArray(ZeroedArray&& other) noexcept {
+        *this = std::move(other);
+    }
+    
+    ZeroedArray& operator=(ZeroedArray&& other) noexcept {
+        if (this != &other) {
+            release();
+            elements = std::exchange(other.elements, nullptr);
+            count = std::exchange(other.count, 0);
+            bytes = std::exchange(other.bytes, 0);
+            mapped = other.mapped;
+            backing = other.backing;
+        }
+        return *this;
+    }
+    
+    ZeroedArray(const ZeroedArray&) = delete;
+    ZeroedArray& operator=(const ZeroedArray&) = delete;
+    
+    ~ZeroedArray() {
+        release();
+    }
+    
+    T& operator[](size_t i) { return elements[i]; }
+    const T& operator[](size_t i) const { return elements[i]; }
+    
+    T* begin() { return elements; }
+    T* end() { return elements + count; }
+    const T* begin() const { return elements; }
+    const T* end() const { return elements + count; }
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    
+    // Bytes reserved for the elements
+    size_t capacityBytes() const { return bytes; }
+    
+    // Page backing actually obtained (Off for small, heap-allocated arrays)
+    HugePages pageBacking() const { return backing; }
+};
+
+#endif // TABLE_MEMORY_HPP
@@ -0,0 +1,454 @@
+#ifndef TIERED_KV_STORE_HPP
+#define TIERED_KV_STORE_HPP
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "kvstore.hpp"
+#include "table_memory.hpp"
+
+// Two-tier store laid out like BOLT's HBM cache plus host pages
+// (BOLT/hbm_distribution_experiment), with the hot tier standing in for HBM:
+//   - hot tier: a small array of values with a queue of free indices (BOLT's
+//     `value` and `queue`), meant to stay cache-resident
+//   - cold tier: pages of PAGE_CAPACITY tuples, filled to half on average
+//     (BOLT's `Page`)
+//   - eviction buffer: per page, blocks naming a key that now belongs to the
+//     page while its value still sits in a hot slot (BOLT's
+//     `Eviction_Buffer_Block`)
+// A position map (a KVStore) records where each key is. Every access
+// re-places its key as in exp_validation/sim.cpp: with probability hotRatio
+// into the hot tier, otherwise into the less loaded of two random pages. A
+// hot key moving to a page only gets a buffer block; the value is copied
+// into the page when that page's buffer is flushed. After each access one
+// or two random pages are flushed, with sim.cpp's dequeue probabilities.
+template<typename K, size_t ValueSize>
+class TieredKVStore {
+private:
+    using Value = std::array<uint8_t, ValueSize>;
+
+    static constexpr size_t PAGE_CAPACITY = 8;
+    static constexpr size_t PAGE_FILL = PAGE_CAPACITY / 2; // Average tuples per page at capacity
+    static constexpr uint32_t NO_SLOT = static_cast<uint32_t>(-1);
+    static constexpr size_t MAX_PAGE_DRAWS = 4; // Random pairs before choosePage() scans
+    static constexpr double POSITION_MAP_LOAD_FACTOR = 0.75;
+
+    enum Tier : uint8_t { Hot = 1, Paged = 2, Buffered = 3 };
+
+    // Position map entry (BOLT's Attribute)
+    struct Location {
+        uint32_t index; // Hot slot (Hot) or page (Paged, Buffered)
+        uint8_t slot;   // Tuple slot (Paged) or buffer block (Buffered)
+        uint8_t tier;
+        uint8_t unused[2];
+    };
+    using LocationBytes = std::array<uint8_t, sizeof(Location)>;
+    using PositionMap = KVStore<K, sizeof(Location)>;
+
+    struct alignas(64) Page {
+        std::array<K, PAGE_CAPACITY> keys;
+        uint32_t occupied; // Bit i set when tuple slot i holds a key
+        std::array<Value, PAGE_CAPACITY> values;
+    };
+
+    struct EvictionBlock {
+        K key;
+        uint32_t hotIndex;
+    };
+
+    struct EvictionBuffer {
+        std::array<EvictionBlock, PAGE_CAPACITY> blocks;
+        uint32_t used; // Bit i set when block i is pending
+    };
+
+    TableMemoryPolicy memoryPolicy;
+    double hotRatio;
+    size_t capacityKeys = 0;
+    size_t pageCount = 0;
+    size_t hotSlots = 0;
+
+    ZeroedArray<Value> hotValues;
+    ZeroedArray<K> hotOwners;      // Key of each hot slot in use
+    std::vector<uint32_t> freeHot; // Ring of free hot indices
+    size_t freeHead = 0;
+    size_t freeCount = 0;
+
+    ZeroedArray<Page> pages;
+    ZeroedArray<EvictionBuffer> buffers;
+    PositionMap positions;
+
+    size_t count = 0;
+    size_t hotKeys = 0;      // Keys whose value is in a hot slot (Hot or Buffered)
+    size_t pendingKeys = 0;  // Buffered keys
+    size_t peakHotUsage = 0; // Most hot slots in use at once
+    size_t hotReads = 0;
+    size_t coldReads = 0;
+
+    uint64_t rngState = 0x9e3779b97f4a7c15ULL;
+
+    // xorshift64*: cheap enough to draw a tier and two pages per access
+    uint64_t random64() {
+        rngState ^= rngState >> 12;
+        rngState ^= rngState << 25;
+        rngState ^= rngState >> 27;
+        return rngState * 0x2545f4914f6cdd1dULL;
+    }
+
+    size_t randomBelow(size_t range) {
+        return static_cast<size_t>(((random64() >> 32) * range) >> 32);
+    }
+
+    double randomUnit() {
+        return (random64() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    static LocationBytes encode(Location location) {
+        LocationBytes bytes;
+        std::memcpy(bytes.data(), &location, sizeof(location));
+        return bytes;
+    }
+
+    static Location decode(const LocationBytes& bytes) {
+        Location location;
+        std::memcpy(&location, bytes.data(), sizeof(location));
+        return location;
+    }
+
+    void setLocation(K key, uint32_t index, uint8_t slot, Tier tier) {
+        positions.update(key, encode({index, slot, static_cast<uint8_t>(tier), {}}));
+    }
+
+    size_t pageLoad(size_t page) const {
+        return __builtin_popcount(pages[page].occupied) + __builtin_popcount(buffers[page].used);
+    }
+
+    // Size the tiers for n keys. The hot tier holds hotRatio of them plus
+    // the keys waiting in eviction buffers, which sim.cpp bounds by
+    // (1 + ratio) * pages / 2 plus a deviation term.
+    void layout(size_t n) {
+        capacityKeys = std::max<size_t>(n, 16);
+        pageCount = (capacityKeys + PAGE_FILL - 1) / PAGE_FILL;
+        double queueBound = (1.0 + hotRatio) * pageCount / 2.0 +
+                            PAGE_CAPACITY * std::sqrt(pageCount * std::log(static_cast<double>(capacityKeys)));
+        hotSlots = static_cast<size_t>(std::ceil(hotRatio * capacityKeys + queueBound));
+        hotValues = ZeroedArray<Value>(hotSlots, memoryPolicy);
+        hotOwners = ZeroedArray<K>(hotSlots, memoryPolicy);
+        freeHot.resize(hotSlots);
+        for (size_t i = 0; i < hotSlots; ++i) {
+            freeHot[i] = static_cast<uint32_t>(i);
+        }
+        freeHead = 0;
+        freeCount = hotSlots;
+        pages = ZeroedArray<Page>(pageCount, memoryPolicy);
+        buffers = ZeroedArray<EvictionBuffer>(pageCount, memoryPolicy);
+        hotKeys = pendingKeys = 0;
+    }
+
+    uint32_t takeHotSlot(K key) {
+        if (freeCount == 0) {
+            return NO_SLOT;
+        }
+        uint32_t index = freeHot[freeHead];
+        hotOwners[index] = key;
+        freeHead = (freeHead + 1) % hotSlots;
+        freeCount--;
+        hotKeys++;
+        peakHotUsage = std::max(peakHotUsage, hotSlots - freeCount);
+        return index;
+    }
+
+    void releaseHotSlot(uint32_t index) {
+        freeHot[(freeHead + freeCount) % hotSlots] = index;
+        freeCount++;
+        hotKeys--;
+    }
+
+    // Less loaded of two random pages. After MAX_PAGE_DRAWS full pairs, the
+    // first page with room from a random start; NO_SLOT only if every page
+    // is full, which the page count (twice capacityKeys over PAGE_CAPACITY)
+    // rules out. A full page stays full when flushed: pageLoad counts its
+    // buffered keys.
+    uint32_t choosePage() {
+        for (size_t draw = 0; draw < MAX_PAGE_DRAWS; ++draw) {
+            size_t a = randomBelow(pageCount);
+            size_t b = randomBelow(pageCount);
+            size_t page = pageLoad(a) <= pageLoad(b) ? a : b;
+            if (pageLoad(page) < PAGE_CAPACITY) {
+                return static_cast<uint32_t>(page);
+            }
+        }
+        size_t start = randomBelow(pageCount);
+        for (size_t i = 0; i < pageCount; ++i) {
+            size_t page = (start + i) % pageCount;
+            if (pageLoad(page) < PAGE_CAPACITY) {
+                return static_cast<uint32_t>(page);
+            }
+        }
+        return NO_SLOT;
+    }
+
+    void putInPage(uint32_t page, K key, const Value& value) {
+        Page& p = pages[page];
+        size_t slot = __builtin_ctz(~p.occupied);
+        p.keys[slot] = key;
+        p.values[slot] = value;
+        p.occupied |= 1u << slot;
+        setLocation(key, page, static_cast<uint8_t>(slot), Paged);
+    }
+
+    void putInBuffer(uint32_t page, K key, uint32_t hotIndex) {
+        EvictionBuffer& buffer = buffers[page];
+        size_t block = __builtin_ctz(~buffer.used);
+        buffer.blocks[block] = {key, hotIndex};
+        buffer.used |= 1u << block;
+        pendingKeys++;
+        setLocation(key, page, static_cast<uint8_t>(block), Buffered);
+    }
+
+    // Copy every pending value of a page out of the hot tier into the page
+    void flush(size_t page) {
+        EvictionBuffer& buffer = buffers[page];
+        for (uint32_t m = buffer.used; m; m &= m - 1) {
+            const EvictionBlock& block = buffer.blocks[__builtin_ctz(m)];
+            putInPage(static_cast<uint32_t>(page), block.key, hotValues[block.hotIndex]);
+            releaseHotSlot(block.hotIndex);
+            pendingKeys--;
+        }
+        buffer.used = 0;
+    }
+
+    // sim.cpp's dequeue step: with probability 2a(1 - a) flush one random
+    // page, with probability (1 - a)^2 two, otherwise none
+    void drain() {
+        double r = randomUnit();
+        double one = 2.0 * hotRatio * (1.0 - hotRatio);
+        double two = one + (1.0 - hotRatio) * (1.0 - hotRatio);
+        if (r < two) {
+            flush(randomBelow(pageCount));
+            if (r >= one) {
+                flush(randomBelow(pageCount));
+            }
+        }
+    }
+
+    // Place a key that has no location yet. store() keeps count within
+    // capacityKeys, so some page has room.
+    void placeNew(K key, const Value& value) {
+        if (randomUnit() < hotRatio) {
+            uint32_t index = takeHotSlot(key);
+            if (index != NO_SLOT) {
+                hotValues[index] = value;
+                setLocation(key, index, 0, Hot);
+                return;
+            }
+        }
+        putInPage(choosePage(), key, value);
+    }
+
+    // Move a located key to a freshly drawn place; its value is value
+    void replace(K key, const Location& from, const Value& value) {
+        bool toHot = randomUnit() < hotRatio;
+        switch (from.tier) {
+            case Hot:
+                hotValues[from.index] = value;
+                if (toHot) {
+                    return;
+                }
+                break;
+            case Buffered: {
+                EvictionBuffer& buffer = buffers[from.index];
+                uint32_t hotIndex = buffer.blocks[from.slot].hotIndex;
+                buffer.used &= ~(1u << from.slot);
+                pendingKeys--;
+                hotValues[hotIndex] = value;
+                if (toHot) {
+                    setLocation(key, hotIndex, 0, Hot);
+                    return;
+                }
+                uint32_t page = choosePage();
+                if (page == NO_SLOT) {
+                    setLocation(key, hotIndex, 0, Hot);
+                } else {
+                    putInBuffer(page, key, hotIndex);
+                }
+                return;
+            }
+            default: // Paged
+                pages[from.index].occupied &= ~(1u << from.slot);
+                if (toHot) {
+                    uint32_t index = takeHotSlot(key);
+                    if (index != NO_SLOT) {
+                        hotValues[index] = value;
+                        setLocation(key, index, 0, Hot);
+                        return;
+                    }
+                }
+                putInPage(choosePage(), key, value);
+                return;
+        }
+        // A hot key headed for a page keeps its slot until the page flushes
+        uint32_t page = choosePage();
+        if (page != NO_SLOT) {
+            putInBuffer(page, key, from.index);
+        }
+    }
+
+    // Shared by every operation on a present key: out receives the value,
+    // newValue (if any) replaces it, and the key is re-placed
+    bool access(K key, Value* out, const Value* newValue) {
+        LocationBytes bytes;
+        if (!positions.getInto(key, bytes.data())) {
+            return false;
+        }
+        Location location = decode(bytes);
+        Value value;
+        if (location.tier == Hot) {
+            value = hotValues[location.index];
+            hotReads++;
+        } else if (location.tier == Buffered) {
+            value = hotValues[buffers[location.index].blocks[location.slot].hotIndex];
+            hotReads++;
+        } else {
+            value = pages[location.index].values[location.slot];
+            coldReads++;
+        }
+        if (out) {
+            *out = value;
+        }
+        replace(key, location, newValue ? *newValue : value);
+        drain();
+        return true;
+    }
+
+    // Move every key into tiers sized for n keys
+    void regrow(size_t n) {
+        std::vector<std::pair<K, Value>> entries;
+        entries.reserve(count);
+        for (size_t page = 0; page < pageCount; ++page) {
+            flush(page);
+            for (uint32_t m = pages[page].occupied; m; m &= m - 1) {
+                size_t slot = __builtin_ctz(m);
+                entries.emplace_back(pages[page].keys[slot], pages[page].values[slot]);
+            }
+        }
+        std::vector<bool> inUse(hotSlots, true);
+        for (size_t i = 0; i < freeCount; ++i) {
+            inUse[freeHot[(freeHead + i) % hotSlots]] = false;
+        }
+        for (size_t index = 0; index < hotSlots; ++index) {
+            if (inUse[index]) {
+                entries.emplace_back(hotOwners[index], hotValues[index]);
+            }
+        }
+        layout(n);
+        for (const auto& [key, value] : entries) {
+            placeNew(key, value);
+        }
+    }
+
+    void store(K key, const Value& value) {
+        if (access(key, nullptr, &value)) {
+            return;
+        }
+        if (count + 1 > capacityKeys) {
+            regrow(capacityKeys * 2);
+        }
+        placeNew(key, value);
+        count++;
+    }
+
+public:
+    using KeyType = K;
+    using ValueType = Value;
+
+    // hotRatio is the share of keys kept in the hot tier, as the HBM share
+    // of hbm_distribution_experiment (1%, 20%, 50%)
+    static constexpr double DEFAULT_HOT_RATIO = 0.2;
+
+    // Constructor that sizes both tiers for dataSize keys
+    explicit TieredKVStore(size_t dataSize = 1000000, double hotRatio = DEFAULT_HOT_RATIO,
+                           const TableMemoryPolicy& memory = {})
+        : memoryPolicy(memory), hotRatio(std::clamp(hotRatio, 0.0, 1.0)),
+          positions(std::max<size_t>(dataSize, 16), POSITION_MAP_LOAD_FACTOR, memory) {
+        layout(dataSize);
+    }
+
+    size_t size() const { return count; }
+
+    double hotTierRatio() const { return hotRatio; }
+
+    // Tier occupancy and read counters
+    struct TierStats {
+        size_t hotSlots;     // Capacity of the hot tier
+        size_t hotKeys;      // Values now in hot slots, pending ones included
+        size_t pendingKeys;  // Keys waiting in eviction buffers
+        size_t peakHotUsage; // Most hot slots in use at once
+        size_t pages;
+        size_t hotReads;     // Accesses served from the hot tier
+        size_t coldReads;    // Accesses served from a page
+    };
+
+    TierStats tierStats() const {
+        return {hotSlots, hotKeys, pendingKeys, peakHotUsage, pageCount, hotReads, coldReads};
+    }
+
+    // Bytes held by both tiers, the eviction buffers and the position map
+    size_t memoryUsage() const {
+        return hotValues.capacityBytes() + hotOwners.capacityBytes() + freeHot.capacity() * sizeof(uint32_t) +
+               pages.capacityBytes() + buffers.capacityBytes() + positions.memoryUsage();
+    }
+
+    ValueType get(K key) {
+        ValueType result{};
+        access(key, &result, nullptr);
+        return result;  // Empty array if not found
+    }
+
+    // Copy the value of key to dst (ValueSize bytes); false, leaving dst
+    // alone, if key is absent. Like every access, this re-places the key.
+    bool getInto(K key, uint8_t* dst) {
+        ValueType value;
+        if (!access(key, &value, nullptr)) {
+            return false;
+        }
+        std::memcpy(dst, value.data(), ValueSize);
+        return true;
+    }
+
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+
+    bool remove(K key) {
+        LocationBytes bytes;
+        if (!positions.getInto(key, bytes.data())) {
+            return false;
+        }
+        Location location = decode(bytes);
+        if (location.tier == Hot) {
+            releaseHotSlot(location.index);
+        } else if (location.tier == Buffered) {
+            EvictionBuffer& buffer = buffers[location.index];
+            releaseHotSlot(buffer.blocks[location.slot].hotIndex);
+            buffer.used &= ~(1u << location.slot);
+            pendingKeys--;
+        } else {
+            pages[location.index].occupied &= ~(1u << location.slot);
+        }
+        positions.remove(key);
+        count--;
+        return true;
+    }
+
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
+    }
+};
+
+#endif // TIERED_KV_STORE_HPP
@@ -0,0 +1,293 @@
+#ifndef TWO_CHOICE_KV_STORE_HPP
+#define TWO_CHOICE_KV_STORE_HPP
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "kvstore.hpp"
+#include "table_memory.hpp"
+
+// CPU version of BOLT's load-balanced bin store (the scheme validated by
+// exp_validation/sim.cpp). Keys live in N/c fixed-capacity bins, and a
+// position map (a KVStore) records each key's bin. Every access (get,
+// update or insert) takes the key out of its bin and puts it into the less
+// loaded of two freshly drawn random bins, which keeps the fullest bin near
+// c + log2(log2(N)) + 1 keys; bins are sized to that bound. Where a key
+// lives is therefore independent of the key and of earlier accesses to it.
+template<typename K, size_t ValueSize>
+class TwoChoiceKVStore {
+private:
+    using Value = std::array<uint8_t, ValueSize>;
+    using Position = std::array<uint8_t, sizeof(uint32_t)>;
+    using PositionMap = KVStore<K, sizeof(uint32_t)>;
+
+    static constexpr size_t NO_BIN = static_cast<size_t>(-1);
+    static constexpr size_t MAX_BIN_DRAWS = 4; // Two-choice draws before placeNew() scans
+    static constexpr double POSITION_MAP_LOAD_FACTOR = 0.75;
+
+    TableMemoryPolicy memoryPolicy;
+    size_t capacityKeys = 0; // N: keys the bins are sized for; doubles when exceeded
+    size_t keysPerBin;       // c: average bin load at N keys
+    size_t binCount = 0;
+    size_t binSlots = 0;     // ceil(c + log2(log2(N)) + 1)
+
+    // Bin b holds its keys and values in slots [b * binSlots, b * binSlots +
+    // loads[b]); removal moves the bin's last entry into the hole
+    ZeroedArray<K> keys;
+    ZeroedArray<Value> values;
+    ZeroedArray<uint16_t> loads;
+    PositionMap positions;
+
+    size_t count = 0; // Live keys
+    size_t maxLoadSeen = 0;
+    size_t fullChoices = 0;
+
+    // PCG32, as in sim.cpp: placement needs two cheap draws per access
+    uint64_t rngState = 0x853c49e6748fea9bULL;
+    static constexpr uint64_t RNG_INCREMENT = 0xda3e39cb94b95bdbULL;
+
+    uint32_t random32() {
+        uint64_t old = rngState;
+        rngState = old * 6364136223846793005ULL + RNG_INCREMENT;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // Uniform in [0, range) by multiply-shift, without a division
+    size_t randomBelow(size_t range) {
+        return static_cast<size_t>((static_cast<uint64_t>(random32()) * range) >> 32);
+    }
+
+    static uint32_t decode(const Position& position) {
+        uint32_t bin;
+        std::memcpy(&bin, position.data(), sizeof(bin));
+        return bin;
+    }
+
+    static Position encode(size_t bin) {
+        Position position;
+        uint32_t b = static_cast<uint32_t>(bin);
+        std::memcpy(position.data(), &b, sizeof(b));
+        return position;
+    }
+
+    // Size the bins for n keys
+    void layout(size_t n) {
+        capacityKeys = std::max<size_t>(n, 4);
+        binCount = std::max<size_t>(2, (capacityKeys + keysPerBin - 1) / keysPerBin);
+        binSlots = static_cast<size_t>(std::ceil(loadBound()));
+        keys = ZeroedArray<K>(binCount * binSlots, memoryPolicy);
+        values = ZeroedArray<Value>(binCount * binSlots, memoryPolicy);
+        loads = ZeroedArray<uint16_t>(binCount, memoryPolicy);
+    }
+
+    size_t findInBin(size_t bin, K key) const {
+        const K* binKeys = &keys[bin * binSlots];
+        for (size_t i = 0; i < loads[bin]; ++i) {
+            if (binKeys[i] == key) {
+                return i;
+            }
+        }
+        return NO_BIN;
+    }
+
+    void append(size_t bin, K key, const Value& value) {
+        size_t slot = bin * binSlots + loads[bin]++;
+        keys[slot] = key;
+        values[slot] = value;
+        maxLoadSeen = std::max<size_t>(maxLoadSeen, loads[bin]);
+    }
+
+    void takeOut(size_t bin, size_t index) {
+        size_t slot = bin * binSlots + index;
+        size_t last = bin * binSlots + --loads[bin];
+        keys[slot] = keys[last];
+        values[slot] = values[last];
+    }
+
+    // Put key into the less loaded of two distinct random bins; NO_BIN if
+    // both are full
+    size_t placeTwoChoice(K key, const Value& value) {
+        size_t a = randomBelow(binCount);
+        size_t b = randomBelow(binCount - 1);
+        if (b >= a) {
+            b++;
+        }
+        size_t bin = loads[a] <= loads[b] ? a : b;
+        if (loads[bin] == binSlots) {
+            fullChoices++;
+            return NO_BIN;
+        }
+        append(bin, key, value);
+        return bin;
+    }
+
+    // Place a key that has no bin yet: MAX_BIN_DRAWS two-choice draws, then
+    // the first bin with room from a random start. store() keeps count
+    // within capacityKeys, which is less than binCount * binSlots, so some
+    // bin has room.
+    size_t placeNew(K key, const Value& value) {
+        for (size_t draw = 0; draw < MAX_BIN_DRAWS; ++draw) {
+            size_t bin = placeTwoChoice(key, value);
+            if (bin != NO_BIN) {
+                return bin;
+            }
+        }
+        size_t start = randomBelow(binCount);
+        for (size_t i = 0; i < binCount; ++i) {
+            size_t bin = (start + i) % binCount;
+            if (loads[bin] < binSlots) {
+                append(bin, key, value);
+                return bin;
+            }
+        }
+        return NO_BIN;
+    }
+
+    // Rebin every key into bins sized for n keys
+    void regrow(size_t n) {
+        std::vector<std::pair<K, Value>> entries;
+        entries.reserve(count);
+        for (size_t bin = 0; bin < binCount; ++bin) {
+            for (size_t i = 0; i < loads[bin]; ++i) {
+                entries.emplace_back(keys[bin * binSlots + i], values[bin * binSlots + i]);
+            }
+        }
+        layout(n);
+        maxLoadSeen = 0;
+        for (const auto& [key, value] : entries) {
+            positions.update(key, encode(placeNew(key, value)));
+        }
+    }
+
+    // Shared by every operation on a present key: out receives the value,
+    // newValue (if any) replaces it, and the key moves to a new bin. A key
+    // whose two choices are both full goes back into its own bin, which has
+    // room since the key just left it.
+    bool access(K key, Value* out, const Value* newValue) {
+        Position position;
+        if (!positions.getInto(key, position.data())) {
+            return false;
+        }
+        size_t bin = decode(position);
+        size_t index = findInBin(bin, key);
+        Value value = values[bin * binSlots + index];
+        if (out) {
+            *out = value;
+        }
+        if (newValue) {
+            value = *newValue;
+        }
+        takeOut(bin, index);
+        size_t dst = placeTwoChoice(key, value);
+        if (dst == NO_BIN) {
+            append(bin, key, value);
+        } else if (dst != bin) {
+            positions.update(key, encode(dst));
+        }
+        return true;
+    }
+
+    void store(K key, const Value& value) {
+        if (access(key, nullptr, &value)) {
+            return;
+        }
+        if (count + 1 > capacityKeys) {
+            regrow(capacityKeys * 2);
+        }
+        positions.insert(key, encode(placeNew(key, value)));
+        count++;
+    }
+
+public:
+    using KeyType = K;
+    using ValueType = Value;
+
+    // keysPerBin is c in the load bound; sim.cpp's DIVISOR
+    static constexpr size_t DEFAULT_KEYS_PER_BIN = 8;
+
+    // Constructor that sizes the bins for dataSize keys
+    explicit TwoChoiceKVStore(size_t dataSize = 1000000, const TableMemoryPolicy& memory = {},
+                              size_t keysPerBin = DEFAULT_KEYS_PER_BIN)
+        : memoryPolicy(memory), keysPerBin(std::max<size_t>(1, keysPerBin)),
+          positions(std::max<size_t>(dataSize, 4), POSITION_MAP_LOAD_FACTOR, memory) {
+        layout(dataSize);
+    }
+
+    size_t size() const { return count; }
+
+    // c + log2(log2(N)) + 1 for the current N and c = N / bins
+    double loadBound() const {
+        double c = static_cast<double>(capacityKeys) / binCount;
+        return c + std::log2(std::log2(static_cast<double>(capacityKeys))) + 1.0;
+    }
+
+    // Bin occupancy counters
+    struct BinStats {
+        size_t bins;
+        size_t binSlots;     // Capacity of each bin, ceil(loadBound())
+        double bound;        // loadBound()
+        size_t maxLoad;      // Fullest bin seen since the last resize
+        size_t currentMax;   // Fullest bin now
+        size_t fullChoices;  // Placements where both drawn bins were full
+    };
+
+    BinStats binStats() const {
+        size_t currentMax = 0;
+        for (size_t bin = 0; bin < binCount; ++bin) {
+            currentMax = std::max<size_t>(currentMax, loads[bin]);
+        }
+        return {binCount, binSlots, loadBound(), maxLoadSeen, currentMax, fullChoices};
+    }
+
+    // Bytes held by the bins plus the position map
+    size_t memoryUsage() const {
+        return keys.capacityBytes() + values.capacityBytes() + loads.capacityBytes() + positions.memoryUsage();
+    }
+
+    ValueType get(K key) {
+        ValueType result{};
+        access(key, &result, nullptr);
+        return result;  // Empty array if not found
+    }
+
+    // Copy the value of key to dst (ValueSize bytes); false, leaving dst
+    // alone, if key is absent. Like every access, this re-places the key.
+    bool getInto(K key, uint8_t* dst) {
+        ValueType value;
+        if (!access(key, &value, nullptr)) {
+            return false;
+        }
+        std::memcpy(dst, value.data(), ValueSize);
+        return true;
+    }
+
+    void insert(K key, const ValueType& value) {
+        store(key, value);
+    }
+
+    bool remove(K key) {
+        Position position;
+        if (!positions.getInto(key, position.data())) {
+            return false;
+        }
+        size_t bin = decode(position);
+        takeOut(bin, findInBin(bin, key));
+        positions.remove(key);
+        count--;
+        return true;
+    }
+
+    void update(K key, const ValueType& newValue) {
+        // Key not found is handled the same way as insert
+        store(key, newValue);
+    }
+};
+
+#endif // TWO_CHOICE_KV_STORE_HPP
@@ -0,0 +1,181 @@
+#ifndef VAR_KV_STORE_HPP
+#define VAR_KV_STORE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "kvstore.hpp"
+#include "slab_allocator.hpp"
+#include "table_memory.hpp"
+
+// Key-value store with variable-length values. The index is a KVStore whose
+// 16-byte inline value is a handle: values of up to INLINE_MAX bytes live in
+// the handle itself, longer ones in a size-class slot that starts with the
+// value's length. One instantiation serves any mix of value sizes, and a
+// lookup of a tiny value never leaves the chain's cache lines.
+template<typename K>
+class VarKVStore {
+private:
+    static constexpr size_t HANDLE_BYTES = 16;
+    using Handle = std::array<uint8_t, HANDLE_BYTES>;
+    using Index = KVStore<K, HANDLE_BYTES>;
+
+    // The last handle byte is the inline length, or OUT_OF_LINE when the
+    // first bytes hold a slot pointer
+    static constexpr size_t TAG = HANDLE_BYTES - 1;
+    static constexpr uint8_t OUT_OF_LINE = 0x80;
+
+    // Slots open with the value length
+    using LengthPrefix = uint32_t;
+    static constexpr size_t PREFIX_BYTES = sizeof(LengthPrefix);
+
+    Index index;
+    SizeClassAllocator slots;
+    size_t payload = 0; // Sum of live value lengths
+
+    static uint8_t* slotOf(const Handle& handle) {
+        uint8_t* slot;
+        std::memcpy(&slot, handle.data(), sizeof(slot));
+        return slot;
+    }
+
+    static size_t slotLength(const uint8_t* slot) {
+        LengthPrefix length;
+        std::memcpy(&length, slot, PREFIX_BYTES);
+        return length;
+    }
+
+    static size_t lengthOf(const Handle& handle) {
+        return handle[TAG] == OUT_OF_LINE ? slotLength(slotOf(handle)) : handle[TAG];
+    }
+
+    static void writeSlot(uint8_t* slot, const uint8_t* data, size_t length) {
+        LengthPrefix prefix = static_cast<LengthPrefix>(length);
+        std::memcpy(slot, &prefix, PREFIX_BYTES);
+        std::memcpy(slot + PREFIX_BYTES, data, length);
+    }
+
+    void release(const Handle& handle) {
+        if (handle[TAG] == OUT_OF_LINE) {
+            uint8_t* slot = slotOf(handle);
+            slots.deallocate(slot, PREFIX_BYTES + slotLength(slot));
+        }
+    }
+
+    // Shared by insert and update: an existing slot is rewritten in place
+    // when the new length falls in its size class, so steady-state updates
+    // that keep their size class touch neither the allocator nor the index.
+    // Oversized slots are sized exactly and always replaced.
+    void store(K key, const uint8_t* data, size_t length) {
+        if (length > UINT32_MAX) {
+            throw std::length_error("VarKVStore value exceeds 4 GB");
+        }
+        Handle old{};
+        bool found = index.visit(key, [&](const Handle& handle) { old = handle; });
+        size_t oldLength = found ? lengthOf(old) : 0;
+
+        size_t sizeClass = SizeClassAllocator::classOf(PREFIX_BYTES + length);
+        if (found && old[TAG] == OUT_OF_LINE && length > INLINE_MAX &&
+            sizeClass != SizeClassAllocator::CLASS_COUNT &&
+            sizeClass == SizeClassAllocator::classOf(PREFIX_BYTES + oldLength)) {
+            writeSlot(slotOf(old), data, length);
+            payload += length - oldLength;
+            return;
+        }
+
+        Handle handle{};
+        if (length <= INLINE_MAX) {
+            if (length > 0) {
+                std::memcpy(handle.data(), data, length);
+            }
+            handle[TAG] = static_cast<uint8_t>(length);
+        } else {
+            uint8_t* slot = static_cast<uint8_t*>(slots.allocate(PREFIX_BYTES + length));
+            writeSlot(slot, data, length);
+            std::memcpy(handle.data(), &slot, sizeof(slot));
+            handle[TAG] = OUT_OF_LINE;
+        }
+        index.update(key, handle);
+        if (found) {
+            release(old);
+        }
+        payload += length - oldLength;
+    }
+
+public:
+    using KeyType = K;
+
+    // Longest value kept in the handle itself
+    static constexpr size_t INLINE_MAX = TAG;
+
+    // Constructor that scales the index based on expected data size
+    explicit VarKVStore(size_t dataSize = 1000000, const TableMemoryPolicy& memory = {})
+        : index(dataSize, memory), slots(memory) {}
+
+    // Constructor that sizes the index for expectedKeys at maxLoadFactor
+    VarKVStore(size_t expectedKeys, double maxLoadFactor, const TableMemoryPolicy& memory = {})
+        : index(expectedKeys, maxLoadFactor, memory), slots(memory) {}
+
+    size_t size() const { return index.size(); }
+
+    // Bytes held by the index plus the value slots
+    size_t memoryUsage() const { return index.memoryUsage() + slots.capacityBytes(); }
+
+    // Bytes of live values, for comparison with memoryUsage()
+    size_t payloadBytes() const { return payload; }
+
+    void insert(K key, const uint8_t* data, size_t length) {
+        store(key, data, length);
+    }
+
+    void update(K key, const uint8_t* data, size_t length) {
+        // Key not found is handled the same way as insert
+        store(key, data, length);
+    }
+
+    // Call f(const uint8_t* data, size_t length) on the value of key where it
+    // is stored and return true, or return false without calling f if key is
+    // absent. The data must not be used after the call.
+    template<typename F>
+    bool visit(K key, F&& f) {
+        return index.visit(key, [&](const Handle& handle) {
+            if (handle[TAG] == OUT_OF_LINE) {
+                const uint8_t* slot = slotOf(handle);
+                std::forward<F>(f)(slot + PREFIX_BYTES, slotLength(slot));
+            } else {
+                std::forward<F>(f)(handle.data(), static_cast<size_t>(handle[TAG]));
+            }
+        });
+    }
+
+    // Copy the value of key into out and return true, or return false and
+    // leave out alone if key is absent. Reusing out across calls avoids
+    // allocating once its capacity covers the largest value.
+    bool getInto(K key, std::vector<uint8_t>& out) {
+        return visit(key, [&](const uint8_t* data, size_t length) { out.assign(data, data + length); });
+    }
+
+    std::vector<uint8_t> get(K key) {
+        std::vector<uint8_t> result;
+        getInto(key, result);
+        return result;  // Empty if not found
+    }
+
+    bool remove(K key) {
+        Handle old{};
+        if (!index.visit(key, [&](const Handle& handle) { old = handle; })) {
+            return false;
+        }
+        payload -= lengthOf(old);
+        release(old);
+        index.remove(key);
+        return true;
+    }
+};
+
+#endif // VAR_KV_STORE_HPP